@@ -0,0 +1,85 @@
+# Generates a header embedding every file in shaders/ as a byte array, with
+# its length and 64-bit FNV-1a hash, and a table sorted by path.
+#
+# cmake -DSOURCE_DIR=<dir> -DOUTPUT=<header> -P embed_shaders.cmake
+
+file(GLOB files RELATIVE ${SOURCE_DIR} ${SOURCE_DIR}/shaders/*)
+list(SORT files)
+
+set(digits "0123456789abcdef")
+
+# Matches glcHashString, the terminator included. The 64-bit state is kept
+# as two 32-bit halves, as CMake only has signed 64-bit math. The FNV prime
+# is 2^40 + 0x1B3, so multiplying is a shift and a small product
+function(fnv1a hex result)
+	string(LENGTH "${hex}" length)
+
+	set(hi 3421674724)
+	set(lo 2216829733)
+
+	set(i 0)
+	while (i LESS_EQUAL length)
+		if (i LESS length)
+			string(SUBSTRING "${hex}" ${i} 1 high)
+			math(EXPR j "${i} + 1")
+			string(SUBSTRING "${hex}" ${j} 1 low)
+
+			string(FIND "${digits}" "${high}" high)
+			string(FIND "${digits}" "${low}" low)
+
+			math(EXPR lo "${lo} ^ (${high} * 16 + ${low})")
+		endif()
+
+		math(EXPR product "${lo} * 435")
+		math(EXPR hi "(${hi} * 435 + (${product} >> 32) + ((${lo} & 16777215) << 8)) & 4294967295")
+		math(EXPR lo "${product} & 4294967295")
+
+		math(EXPR i "${i} + 2")
+	endwhile()
+
+	set(${result} "(((uint64_t) ${hi}u) << 32) | ${lo}u" PARENT_SCOPE)
+endfunction()
+
+# 16 bytes per line, CMake regexes have no repetition counts
+set(line "")
+foreach (i RANGE 1 16)
+	string(APPEND line "0x[0-9a-f][0-9a-f], ")
+endforeach()
+
+set(arrays "")
+set(table "")
+set(index 0)
+
+foreach (file ${files})
+	file(READ ${SOURCE_DIR}/${file} hex HEX)
+	string(TOLOWER "${hex}" hex)
+	string(LENGTH "${hex}" length)
+	math(EXPR length "${length} / 2")
+
+	fnv1a("${hex}" hash)
+
+	string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " bytes "${hex}")
+	string(REGEX REPLACE "(${line})" "\\1\n\t" bytes "${bytes}")
+	string(REPLACE ", \n" ",\n" bytes "${bytes}")
+
+	string(APPEND arrays "// ${file}\nstatic const unsigned char glcEmbeddedData${index}[] = {\n\t${bytes}0x00\n};\n\n")
+	string(APPEND table "\t{ \"${file}\", (const char*) glcEmbeddedData${index}, ${length}, ${hash} },\n")
+
+	math(EXPR index "${index} + 1")
+endforeach()
+
+set(content "// Generated by cmake/embed_shaders.cmake, do not edit\n\n")
+string(APPEND content "#ifndef GLC_EMBEDDED_SHADERS_H\n#define GLC_EMBEDDED_SHADERS_H\n\n")
+string(APPEND content "${arrays}")
+string(APPEND content "// Sorted by path\nstatic const GLCEmbeddedFile glcEmbeddedFiles[] = {\n${table}\t{ NULL, NULL, 0, 0 }\n};\n\n")
+string(APPEND content "static const size_t glcEmbeddedFileCount = ${index};\n\n#endif\n")
+
+# Only touches the header when the contents changed, such that unchanged
+# shaders do not rebuild the examples
+if (EXISTS ${OUTPUT})
+	file(READ ${OUTPUT} previous)
+endif()
+
+if (NOT "${previous}" STREQUAL "${content}")
+	file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -0,0 +1,335 @@
+# Generates a header with the interface of every program in shaders/, the
+# stages of a program being the files sharing its name. Uniforms and vertex
+# inputs must have an explicit layout(location = N), and uniform blocks must
+# be layout(std140, binding = N), such that nothing is looked up at runtime.
+#
+# cmake -DSOURCE_DIR=<dir> -DOUTPUT=<header> -P generate_shader_interface.cmake
+
+cmake_minimum_required(VERSION 3.12)
+
+file(GLOB files RELATIVE ${SOURCE_DIR} ${SOURCE_DIR}/shaders/*)
+list(SORT files)
+
+set(identifier "[A-Za-z_][A-Za-z0-9_]*")
+
+# lightColor -> LIGHT_COLOR
+function(macro_name name result)
+	string(REGEX REPLACE "([a-z0-9])([A-Z])" "\\1_\\2" name "${name}")
+	string(TOUPPER "${name}" name)
+	set(${result} "${name}" PARENT_SCOPE)
+endfunction()
+
+# visualize_normals -> VisualizeNormals
+function(type_name name result)
+	string(REPLACE "_" ";" words "${name}")
+	set(type "")
+	foreach (word ${words})
+		string(SUBSTRING "${word}" 0 1 first)
+		string(SUBSTRING "${word}" 1 -1 rest)
+		string(TOUPPER "${first}" first)
+		string(APPEND type "${first}${rest}")
+	endforeach()
+	set(${result} "${type}" PARENT_SCOPE)
+endfunction()
+
+# Sets <prefix>_BASE (C type), _COMPONENTS, _BLOCK_COMPONENTS (in std140,
+# matrix columns padded to vec4), _ALIGNMENT (std140, bytes) and _SETTER
+function(glsl_type type prefix)
+	set(base float)
+	set(matrix 0)
+
+	if (type STREQUAL "float")
+		set(components 1)
+		set(alignment 4)
+		set(setter glUniform1fv)
+	elseif (type MATCHES "^vec([234])$")
+		set(components ${CMAKE_MATCH_1})
+		set(setter glUniform${CMAKE_MATCH_1}fv)
+	elseif (type MATCHES "^(int|bool)$" OR type MATCHES "sampler")
+		set(base GLint)
+		set(components 1)
+		set(alignment 4)
+		set(setter glUniform1iv)
+	elseif (type MATCHES "^[ib]vec([234])$")
+		set(base GLint)
+		set(components ${CMAKE_MATCH_1})
+		set(setter glUniform${CMAKE_MATCH_1}iv)
+	elseif (type STREQUAL "uint")
+		set(base GLuint)
+		set(components 1)
+		set(alignment 4)
+		set(setter glUniform1uiv)
+	elseif (type MATCHES "^uvec([234])$")
+		set(base GLuint)
+		set(components ${CMAKE_MATCH_1})
+		set(setter glUniform${CMAKE_MATCH_1}uiv)
+	elseif (type MATCHES "^mat([234])$")
+		set(matrix ${CMAKE_MATCH_1})
+		math(EXPR components "${matrix} * ${matrix}")
+		set(setter glUniformMatrix${matrix}fv)
+	else()
+		message(FATAL_ERROR "Unsupported uniform type ${type}")
+	endif()
+
+	if (matrix)
+		set(alignment 16)
+		math(EXPR block_components "${matrix} * 4")
+	else()
+		set(block_components ${components})
+
+		if (components EQUAL 2)
+			set(alignment 8)
+		elseif (components GREATER 2)
+			set(alignment 16)
+		endif()
+	endif()
+
+	set(${prefix}_BASE ${base} PARENT_SCOPE)
+	set(${prefix}_COMPONENTS ${components} PARENT_SCOPE)
+	set(${prefix}_BLOCK_COMPONENTS ${block_components} PARENT_SCOPE)
+	set(${prefix}_ALIGNMENT ${alignment} PARENT_SCOPE)
+	set(${prefix}_SETTER ${setter} PARENT_SCOPE)
+	set(${prefix}_MATRIX ${matrix} PARENT_SCOPE)
+endfunction()
+
+# Group the stages by program name
+set(programs "")
+
+foreach (file ${files})
+	get_filename_component(name ${file} NAME_WE)
+	list(APPEND programs ${name})
+	list(APPEND stages_${name} ${file})
+endforeach()
+
+list(REMOVE_DUPLICATES programs)
+
+set(blocks "")
+set(content "")
+
+foreach (program ${programs})
+	set(uniforms "")
+	set(attributes "")
+
+	foreach (file ${stages_${program}})
+		file(READ ${SOURCE_DIR}/${file} source)
+
+		# One list element per line, semicolons are not needed to parse declarations
+		string(REGEX REPLACE "//[^\n]*" "" source "${source}")
+		string(REPLACE "\r" "" source "${source}")
+		string(REPLACE ";" "" source "${source}")
+		string(REPLACE "\n" ";" lines "${source}")
+
+		set(block "")
+
+		foreach (line ${lines})
+			string(STRIP "${line}" line)
+
+			if (block)
+				if (line MATCHES "^}")
+					set(block "")
+				elseif (line MATCHES "^(${identifier})[ \t]+(${identifier})[ \t]*(\\[([0-9]+)\\])?$")
+					list(APPEND block_${block}_members ${CMAKE_MATCH_2})
+					set(block_${block}_${CMAKE_MATCH_2}_type ${CMAKE_MATCH_1})
+					set(block_${block}_${CMAKE_MATCH_2}_count "${CMAKE_MATCH_4}")
+				elseif (NOT line STREQUAL "" AND NOT line STREQUAL "{")
+					# Anything else would silently leave the struct with the wrong std140 layout
+					message(FATAL_ERROR "${file}: unsupported block member: ${line}")
+				endif()
+			elseif (line MATCHES "^layout[ \t]*\\(([^)]*)\\)[ \t]*uniform[ \t]+(${identifier})[ \t]*{?$")
+				set(block ${CMAKE_MATCH_2})
+				set(qualifiers "${CMAKE_MATCH_1}")
+
+				if (NOT qualifiers MATCHES "std140" OR NOT qualifiers MATCHES "binding[ \t]*=[ \t]*([0-9]+)")
+					message(FATAL_ERROR "${file}: block ${block} must be layout(std140, binding = N)")
+				endif()
+
+				if (DEFINED block_${block}_binding AND NOT block_${block}_binding EQUAL CMAKE_MATCH_1)
+					message(FATAL_ERROR "${file}: block ${block} is bound to both ${block_${block}_binding} and ${CMAKE_MATCH_1}")
+				endif()
+
+				# Blocks shared by several stages or programs are emitted once
+				if (DEFINED block_${block}_binding)
+					set(block "")
+				else()
+					set(block_${block}_binding ${CMAKE_MATCH_1})
+					set(block_${block}_members "")
+					list(APPEND blocks ${block})
+				endif()
+
+				# Skips the members of an already known block
+				if (NOT block)
+					set(block _skip)
+				endif()
+			elseif (line MATCHES "^layout[ \t]*\\([ \t]*location[ \t]*=[ \t]*([0-9]+)[ \t]*\\)[ \t]*uniform[ \t]+(${identifier})[ \t]+(${identifier})[ \t]*(\\[([0-9]+)\\])?")
+				set(name ${CMAKE_MATCH_3})
+
+				if (DEFINED uniform_${name}_location AND NOT uniform_${name}_location EQUAL CMAKE_MATCH_1)
+					message(FATAL_ERROR "${file}: uniform ${name} has different locations between stages")
+				endif()
+
+				if (NOT DEFINED uniform_${name}_location)
+					list(APPEND uniforms ${name})
+				endif()
+
+				set(uniform_${name}_location ${CMAKE_MATCH_1})
+				set(uniform_${name}_type ${CMAKE_MATCH_2})
+				set(uniform_${name}_count "${CMAKE_MATCH_5}")
+			elseif (line MATCHES "^(layout[ \t]*\\([^)]*\\)[ \t]*)?uniform[ \t]")
+				message(FATAL_ERROR "${file}: uniforms must have an explicit layout(location = N): ${line}")
+			elseif (file MATCHES "\\.vert$")
+				if (line MATCHES "^layout[ \t]*\\([ \t]*location[ \t]*=[ \t]*([0-9]+)[ \t]*\\)[ \t]*in[ \t]+(${identifier})[ \t]+(${identifier})")
+					list(APPEND attributes ${CMAKE_MATCH_3})
+					set(attribute_${CMAKE_MATCH_3}_location ${CMAKE_MATCH_1})
+				elseif (line MATCHES "^in[ \t]")
+					message(FATAL_ERROR "${file}: vertex inputs must have an explicit layout(location = N): ${line}")
+				endif()
+			endif()
+		endforeach()
+
+		unset(block__skip_members)
+	endforeach()
+
+	macro_name(${program} PROGRAM)
+	type_name(${program} Program)
+
+	string(APPEND content "// shaders/${program}.*\n\n")
+
+	if (attributes)
+		foreach (name ${attributes})
+			macro_name(${name} NAME)
+			string(APPEND content "#define GLC_${PROGRAM}_${NAME}_LOCATION ${attribute_${name}_location}\n")
+		endforeach()
+
+		string(APPEND content "\n")
+	endif()
+
+	if (uniforms)
+		set(locations "")
+		set(members "")
+		set(setters "")
+
+		foreach (name ${uniforms})
+			set(location ${uniform_${name}_location})
+
+			if (location IN_LIST used_locations)
+				message(FATAL_ERROR "${program}: uniform ${name} reuses location ${location}")
+			endif()
+
+			list(APPEND used_locations ${location})
+
+			macro_name(${name} NAME)
+			glsl_type(${uniform_${name}_type} T)
+
+			set(count "${uniform_${name}_count}")
+			set(dimensions "")
+			set(pointer "uniforms->${name}")
+
+			if (count)
+				string(APPEND dimensions "[${count}]")
+
+				if (T_COMPONENTS GREATER 1)
+					string(APPEND pointer "[0]")
+				endif()
+			else()
+				set(count 1)
+
+				if (T_COMPONENTS EQUAL 1)
+					set(pointer "&${pointer}")
+				endif()
+			endif()
+
+			if (T_COMPONENTS GREATER 1)
+				string(APPEND dimensions "[${T_COMPONENTS}]")
+			endif()
+
+			string(APPEND locations "#define GLC_${PROGRAM}_${NAME}_LOCATION ${location}\n")
+			string(APPEND members "\t${T_BASE} ${name}${dimensions};\n")
+
+			if (T_MATRIX)
+				string(APPEND setters "\t${T_SETTER}(GLC_${PROGRAM}_${NAME}_LOCATION, ${count}, GL_FALSE, ${pointer});\n")
+			else()
+				string(APPEND setters "\t${T_SETTER}(GLC_${PROGRAM}_${NAME}_LOCATION, ${count}, ${pointer});\n")
+			endif()
+		endforeach()
+
+		unset(used_locations)
+
+		string(APPEND content "${locations}\n")
+		string(APPEND content "typedef struct GLC${Program}Uniforms\n{\n${members}} GLC${Program}Uniforms;\n\n")
+		string(APPEND content "// Requires the program to be in use\n")
+		string(APPEND content "void glcSet${Program}Uniforms(const GLC${Program}Uniforms *uniforms)\n{\n${setters}}\n\n")
+	endif()
+
+	foreach (name ${uniforms})
+		unset(uniform_${name}_location)
+	endforeach()
+endforeach()
+
+foreach (block ${blocks})
+	macro_name(${block} BLOCK)
+
+	set(members "")
+	set(asserts "")
+	set(offset 0)
+	set(padding 0)
+
+	foreach (name ${block_${block}_members})
+		glsl_type(${block_${block}_${name}_type} T)
+
+		set(count "${block_${block}_${name}_count}")
+		set(alignment ${T_ALIGNMENT})
+
+		if (count)
+			# Array elements are padded to a vec4
+			math(EXPR stride "((${T_BLOCK_COMPONENTS} + 3) / 4) * 4")
+			math(EXPR size "${stride} * 4 * ${count}")
+			set(alignment 16)
+			set(dimensions "[${count}][${stride}]")
+		else()
+			math(EXPR size "${T_BLOCK_COMPONENTS} * 4")
+			set(dimensions "")
+
+			if (T_BLOCK_COMPONENTS GREATER 1)
+				set(dimensions "[${T_BLOCK_COMPONENTS}]")
+			endif()
+		endif()
+
+		math(EXPR aligned "(${offset} + ${alignment} - 1) / ${alignment} * ${alignment}")
+
+		if (aligned GREATER offset)
+			math(EXPR floats "(${aligned} - ${offset}) / 4")
+			string(APPEND members "\tfloat _padding${padding}[${floats}];\n")
+			math(EXPR padding "${padding} + 1")
+		endif()
+
+		string(APPEND members "\t${T_BASE} ${name}${dimensions};\n")
+		string(APPEND asserts "static_assert(offsetof(GLC${block}Block, ${name}) == ${aligned}, \"${block}.${name} does not match std140\");\n")
+
+		math(EXPR offset "${aligned} + ${size}")
+	endforeach()
+
+	math(EXPR size "(${offset} + 15) / 16 * 16")
+
+	if (size GREATER offset)
+		math(EXPR floats "(${size} - ${offset}) / 4")
+		string(APPEND members "\tfloat _padding${padding}[${floats}];\n")
+	endif()
+
+	string(APPEND content "// uniform ${block}, std140\n\n")
+	string(APPEND content "#define GLC_${BLOCK}_BINDING ${block_${block}_binding}\n\n")
+	string(APPEND content "typedef struct GLC${block}Block\n{\n${members}} GLC${block}Block;\n\n")
+	string(APPEND content "static_assert(sizeof(GLC${block}Block) == ${size}, \"${block} does not match std140\");\n${asserts}\n")
+endforeach()
+
+set(header "// Generated by cmake/generate_shader_interface.cmake, do not edit\n\n")
+string(APPEND header "#ifndef GLC_SHADER_INTERFACE_H\n#define GLC_SHADER_INTERFACE_H\n\n")
+string(APPEND header "#include <stddef.h>\n\n// Include after gl.h\n\n")
+string(APPEND header "${content}#endif\n")
+
+if (EXISTS ${OUTPUT})
+	file(READ ${OUTPUT} previous)
+endif()
+
+if (NOT "${previous}" STREQUAL "${header}")
+	file(WRITE ${OUTPUT} "${header}")
+endif()
@@ -1,9 +1,13 @@
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 #include "gl.h"
 #include "shader.h"
+#include "program_cache.h"
+#include "shader_reflection.h"
+#include "mesh.h"
 #include "linmath.h"
 #include "glfw_utilities.h"
 
@@ -55,6 +59,24 @@ int main(int argc, char *argv[])
 			"    gl_Position = mvp * vec4(position, 1.0);\n"
 			"}\n";
 
+	// The model matrix is a per-instance attribute, taking 4 locations
+	static const GLchar *instancedVertexShaderSource =
+			"#version 330 core\n"
+			"\n"
+			"out vec3 vNormal;\n"
+			"\n"
+			"in vec3 position;\n"
+			"in vec3 normal;\n"
+			"in mat4 model;\n"
+			"\n"
+			"uniform mat4 viewProjection;\n"
+			"\n"
+			"void main()\n"
+			"{\n"
+			"    vNormal = normal;\n"
+			"    gl_Position = viewProjection * model * vec4(position, 1.0);\n"
+			"}\n";
+
 	static const GLchar *fragmentShaderSource =
 			"#version 330 core\n"
 			"\n"
@@ -67,99 +89,92 @@ int main(int argc, char *argv[])
 			"    fragColor = vec4(abs(vNormal), 1.0);\n"
 			"}\n";
 
-	const GLuint vertexShader   = glcCreateShader(GL_VERTEX_SHADER, vertexShaderSource);
-	const GLuint fragmentShader = glcCreateShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+	// cube [count] [--per-draw], space switches between the paths
+	int cubeCount = 1;
+	int instanced = 1;
 
-	if ((vertexShader == GLC_NULL_HANDLE) || (fragmentShader == GLC_NULL_HANDLE))
-		return EXIT_FAILURE;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--per-draw") == 0)
+			instanced = 0;
+		else if (atoi(argv[i]) > 0)
+			cubeCount = atoi(argv[i]);
+	}
 
-	const GLuint program = glcCreateProgram(vertexShader, fragmentShader);
+	GLCProgramCache programCache;
+	glcProgramCacheInit(&programCache);
 
-	if (program == GLC_NULL_HANDLE)
+	const GLuint program = glcProgramCacheCreateProgram(&programCache, vertexShaderSource, fragmentShaderSource);
+	const GLuint instancedProgram = glcProgramCacheCreateProgram(&programCache, instancedVertexShaderSource, fragmentShaderSource);
+
+	if ((program == GLC_NULL_HANDLE) || (instancedProgram == GLC_NULL_HANDLE))
 		return EXIT_FAILURE;
 
-	glDeleteShader(fragmentShader);
-	glDeleteShader(vertexShader);
+	glcProgramCachePrintStats(&programCache);
 
-	glUseProgram(program);
+	GLCProgramReflection reflection, instancedReflection;
 
-	const GLint positionLocation = glGetAttribLocation(program, "position");
-	const GLint normalLocation   = glGetAttribLocation(program, "normal");
+	if (!glcReflectProgram(&reflection, program) || !glcReflectProgram(&instancedReflection, instancedProgram))
+		return EXIT_FAILURE;
 
-	const GLint mvpLocation = glGetUniformLocation(program, "mvp");
+	const GLint positionLocation = glcReflectionGetAttribLocation(&reflection, glcInternName("position"));
+	const GLint normalLocation   = glcReflectionGetAttribLocation(&reflection, glcInternName("normal"));
 
-	if ((positionLocation == -1) || (normalLocation == -1))
-		return EXIT_FAILURE;
+	const GLint mvpLocation = glcReflectionGetUniformLocation(&reflection, glcInternName("mvp"));
 
-	static const GLfloat vertices[] = {
-			// X, Y, Z, NX, NY, NZ
+	const GLint instancedPositionLocation = glcReflectionGetAttribLocation(&instancedReflection, glcInternName("position"));
+	const GLint instancedNormalLocation   = glcReflectionGetAttribLocation(&instancedReflection, glcInternName("normal"));
+	const GLint instancedModelLocation    = glcReflectionGetAttribLocation(&instancedReflection, glcInternName("model"));
 
-			// Front
-			-0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Left
-			-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Left
-			 0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Right
+	const GLint viewProjectionLocation = glcReflectionGetUniformLocation(&instancedReflection, glcInternName("viewProjection"));
 
-			 0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Right
-			-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Left
-			 0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Right
+	if ((positionLocation == -1) || (normalLocation == -1) ||
+	    (instancedPositionLocation == -1) || (instancedNormalLocation == -1) || (instancedModelLocation == -1))
+		return EXIT_FAILURE;
 
-			// Back
-			 0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Left
-			 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Left
-			-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Right
+	static const GLsizei vertexSize = GLC_CUBE_VERTEX_SIZE;
+	static const GLsizei vertexCount = glcCubeVertexCount;
 
-			-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Right
-			 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Left
-			-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Right
+	// The cubes fill a grid, each with its own fixed rotation
+	int gridSize = 1;
 
-			// Top
-			-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Left
-			-0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Left
-			 0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Right
+	while (gridSize * gridSize * gridSize < cubeCount)
+		++gridSize;
 
-			 0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Right
-			-0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Left
-			 0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Right
+	static const float spacing = 1.5f;
 
-			 // Bottom
-			-0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Left
-			-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Left
-			 0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Right
+	float *models = (float*) malloc((size_t) cubeCount * 16 * sizeof(float));
 
-			 0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Right
-			-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Left
-			 0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Right
+	// Only needed by the per-draw path, allocated once it is used
+	float *mvps = NULL;
 
-			// Right
-			0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Top Left
-			0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Bottom Left
-			0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Top Right
+	if (!models)
+		return EXIT_FAILURE;
 
-			0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Top Right
-			0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Bottom Left
-			0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Bottom Right
+	for (int i = 0; i < cubeCount; ++i)
+	{
+		const float x = ((float) (i % gridSize) - (float) (gridSize - 1) * 0.5f) * spacing;
+		const float y = ((float) ((i / gridSize) % gridSize) - (float) (gridSize - 1) * 0.5f) * spacing;
+		const float z = ((float) (i / (gridSize * gridSize)) - (float) (gridSize - 1) * 0.5f) * spacing;
 
-			// Left
-			-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Top Left
-			-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Bottom Left
-			-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Top Right
+		mat4Translation(models + i * 16, x, y, z);
+		mat4Rotate(models + i * 16, (float) i * 0.7f, 0.0f, 1.0f, 0.0f);
+	}
 
-			-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Top Right
-			-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Bottom Left
-			-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Bottom Right
-	};
+	GLuint vaos[2], vbo, instanceVbo;
 
-	static const GLsizei vertexSize = 6;
-	static const GLsizei vertexCount = sizeof(vertices) / sizeof(*vertices) / vertexSize;
+	glCreateBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glcCubeVertices), glcCubeVertices, GL_STATIC_DRAW);
 
-	GLuint vao, vbo;
+	glGenBuffers(1, &instanceVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) cubeCount * 16 * sizeof(float), models, GL_STATIC_DRAW);
 
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	glGenVertexArrays(2, vaos);
 
-	glCreateBuffers(1, &vbo);
+	glBindVertexArray(vaos[0]);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray((GLuint)positionLocation);
 	glVertexAttribPointer((GLuint)positionLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), 0);
@@ -167,49 +182,133 @@ int main(int argc, char *argv[])
 	glEnableVertexAttribArray((GLuint)normalLocation);
 	glVertexAttribPointer((GLuint)normalLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
 
+	glBindVertexArray(vaos[1]);
+
+	glEnableVertexAttribArray((GLuint)instancedPositionLocation);
+	glVertexAttribPointer((GLuint)instancedPositionLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), 0);
+
+	glEnableVertexAttribArray((GLuint)instancedNormalLocation);
+	glVertexAttribPointer((GLuint)instancedNormalLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+
+	// A column per location, advancing once per instance
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		const GLuint location = (GLuint)instancedModelLocation + column;
+
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(column * 4 * sizeof(GLfloat)));
+		glVertexAttribDivisor(location, 1);
+	}
+
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	float model[16], view[16], projection[16];
-	float mvp[16];
-	float temp[16];
+	float view[16], projection[16], viewProjection[16];
+
+	// Far enough back to see the whole grid
+	const float extent = (float) gridSize * spacing;
+	const float distance = extent + 1.0f;
 
-	static const float fov   = 70.0f;
+	static const float fov = 70.0f;
 	static const float zNear = 0.01f;
-	static const float zFar  = 10.0f;
+	const float zFar = distance + extent * 2.0f;
+
+	int spaceDown = 0;
+
+	double cpuTime = 0.0;
+	int cpuFrames = 0;
+	double reportTime = glfwGetTime();
 
 	while (!glfwWindowShouldClose(window))
 	{
+		const int space = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+
+		if (space && !spaceDown)
+		{
+			instanced = !instanced;
+
+			cpuTime = 0.0;
+			cpuFrames = 0;
+		}
+
+		spaceDown = space;
+
 		int viewportWidth, viewportHeight;
 		glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
 
-		if (mvpLocation != -1)
-		{
-			const float aspect = static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight);
-			const float time = static_cast<GLfloat>(glfwGetTime());
+		// Everything up to the swap, which waits for the GPU
+		const double frameStart = glfwGetTime();
 
-			mat4Perspective(projection, fov, aspect, zNear, zFar);
-			mat4Translation(view, 0.0f, 0.0f, -2.0f);
-			mat4Rotation(model, time, 0.0f, 1.0f, 0.0f);
+		const float aspect = static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight);
+		const float time = static_cast<GLfloat>(frameStart);
 
-			mat4Multiply(temp, projection, view);
-			mat4Multiply(mvp, temp, model);
+		mat4Translation(view, 0.0f, 0.0f, -distance);
+		mat4Rotate(view, time, 0.0f, 1.0f, 0.0f);
 
-			glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, mvp);
-		}
+		mat4Perspective(projection, fov, aspect, zNear, zFar);
+		mat4Multiply(viewProjection, projection, view);
 
 		glViewport(0, 0, viewportWidth, viewportHeight);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+		if (instanced)
+		{
+			glUseProgram(instancedProgram);
+			glBindVertexArray(vaos[1]);
+
+			glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, viewProjection);
+
+			glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, cubeCount);
+		}
+		else
+		{
+			if (!mvps)
+				mvps = (float*) malloc((size_t) cubeCount * 16 * sizeof(float));
+
+			if (!mvps)
+				break;
+
+			glUseProgram(program);
+			glBindVertexArray(vaos[0]);
+
+			mat4MultiplyBatch(mvps, viewProjection, models, (size_t) cubeCount);
+
+			for (int i = 0; i < cubeCount; ++i)
+			{
+				glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, mvps + i * 16);
+				glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+			}
+		}
+
+		cpuTime += glfwGetTime() - frameStart;
+		++cpuFrames;
+
+		if (glfwGetTime() - reportTime >= 1.0)
+		{
+			printf("%s: %d cubes, %.3f ms CPU per frame\n", instanced ? "Instanced" : "Per-draw", cubeCount, cpuTime * 1000.0 / (double) cpuFrames);
+
+			cpuTime = 0.0;
+			cpuFrames = 0;
+			reportTime = glfwGetTime();
+		}
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
-	glDeleteVertexArrays(1, &vao);
+	free(mvps);
+	free(models);
+
+	glDeleteVertexArrays(2, vaos);
+	glDeleteBuffers(1, &instanceVbo);
 	glDeleteBuffers(1, &vbo);
 
+	glcReflectionDestroy(&instancedReflection);
+	glcReflectionDestroy(&reflection);
+
+	glDeleteProgram(instancedProgram);
 	glDeleteProgram(program);
 
 	glfwDestroyWindow(window);
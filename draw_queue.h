@@ -0,0 +1,279 @@
+#ifndef GLC_DRAW_QUEUE_H
+#define GLC_DRAW_QUEUE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "gl_state.h"
+
+// Sort key layout, most significant first. Programs, vertex arrays and
+// materials are truncated to their low bits, which only affects grouping,
+// as the command holds the actual names
+#define GLC_DRAW_KEY_PASS_BITS          4
+#define GLC_DRAW_KEY_PROGRAM_BITS      12
+#define GLC_DRAW_KEY_VERTEX_ARRAY_BITS 12
+#define GLC_DRAW_KEY_MATERIAL_BITS     12
+#define GLC_DRAW_KEY_DEPTH_BITS        24
+
+#define GLC_DRAW_KEY_DEPTH_SHIFT        0
+#define GLC_DRAW_KEY_MATERIAL_SHIFT     (GLC_DRAW_KEY_DEPTH_SHIFT + GLC_DRAW_KEY_DEPTH_BITS)
+#define GLC_DRAW_KEY_VERTEX_ARRAY_SHIFT (GLC_DRAW_KEY_MATERIAL_SHIFT + GLC_DRAW_KEY_MATERIAL_BITS)
+#define GLC_DRAW_KEY_PROGRAM_SHIFT      (GLC_DRAW_KEY_VERTEX_ARRAY_SHIFT + GLC_DRAW_KEY_VERTEX_ARRAY_BITS)
+#define GLC_DRAW_KEY_PASS_SHIFT         (GLC_DRAW_KEY_PROGRAM_SHIFT + GLC_DRAW_KEY_PROGRAM_BITS)
+
+#define GLC_DRAW_KEY_FIELD(value, bits, shift) ((((uint64_t) (value)) & ((1ull << (bits)) - 1)) << (shift))
+
+typedef struct GLCDrawCommand
+{
+	uint64_t key;
+
+	GLuint program, vertexArray;
+	uint32_t material;
+
+	GLenum mode;
+	GLint first;
+	GLsizei count;
+
+	// glDrawElements if not 0, with indices as the byte offset
+	GLenum indexType;
+	const GLvoid *indices;
+
+	// Bound to uniformBinding with glBindBufferRange, if uniformSize is not 0
+	GLuint uniformBuffer, uniformBinding;
+	GLintptr uniformOffset;
+	GLsizeiptr uniformSize;
+} GLCDrawCommand;
+
+typedef struct GLCDrawSortItem
+{
+	uint64_t key;
+	uint32_t index;
+} GLCDrawSortItem;
+
+typedef struct GLCDrawQueueStats
+{
+	unsigned int draws;
+
+	// State changes in sorted order, and in the order the draws were pushed
+	unsigned int programChanges, vertexArrayChanges, materialChanges;
+	unsigned int unsortedProgramChanges, unsortedVertexArrayChanges, unsortedMaterialChanges;
+
+	// Radix passes skipped as every key had the same byte
+	unsigned int skippedPasses;
+} GLCDrawQueueStats;
+
+// Binds the material before the draws using it
+typedef void (*GLCBindMaterial)(GLCStateCache *state, uint32_t material, void *user);
+
+typedef struct GLCDrawQueue
+{
+	GLCDrawCommand *commands;
+	GLCDrawSortItem *items, *scratch;
+
+	size_t count, capacity;
+
+	GLCDrawQueueStats stats;
+} GLCDrawQueue;
+
+// depth is the view depth divided by the far plane. Opaque passes sort front
+// to back, such that early depth testing rejects hidden fragments. Passes
+// blending back to front should pass 1 - depth
+uint64_t glcDrawKey(unsigned int pass, GLuint program, GLuint vertexArray, uint32_t material, float depth)
+{
+	if (!(depth > 0.0f))
+		depth = 0.0f;
+	else if (depth > 1.0f)
+		depth = 1.0f;
+
+	const uint32_t quantized = (uint32_t) (depth * (float) ((1u << GLC_DRAW_KEY_DEPTH_BITS) - 1));
+
+	return GLC_DRAW_KEY_FIELD(pass, GLC_DRAW_KEY_PASS_BITS, GLC_DRAW_KEY_PASS_SHIFT) |
+	       GLC_DRAW_KEY_FIELD(program, GLC_DRAW_KEY_PROGRAM_BITS, GLC_DRAW_KEY_PROGRAM_SHIFT) |
+	       GLC_DRAW_KEY_FIELD(vertexArray, GLC_DRAW_KEY_VERTEX_ARRAY_BITS, GLC_DRAW_KEY_VERTEX_ARRAY_SHIFT) |
+	       GLC_DRAW_KEY_FIELD(material, GLC_DRAW_KEY_MATERIAL_BITS, GLC_DRAW_KEY_MATERIAL_SHIFT) |
+	       GLC_DRAW_KEY_FIELD(quantized, GLC_DRAW_KEY_DEPTH_BITS, GLC_DRAW_KEY_DEPTH_SHIFT);
+}
+
+void glcDrawQueueInit(GLCDrawQueue *queue)
+{
+	memset(queue, 0, sizeof(GLCDrawQueue));
+}
+
+void glcDrawQueueDestroy(GLCDrawQueue *queue)
+{
+	free(queue->commands);
+	free(queue->items);
+	free(queue->scratch);
+
+	memset(queue, 0, sizeof(GLCDrawQueue));
+}
+
+// Empties the queue for the next frame, keeping its memory
+void glcDrawQueueReset(GLCDrawQueue *queue)
+{
+	queue->count = 0;
+}
+
+// Returns 0 if out of memory
+int glcDrawQueuePush(GLCDrawQueue *queue, const GLCDrawCommand *command)
+{
+	if (queue->count == queue->capacity)
+	{
+		const size_t capacity = queue->capacity ? (queue->capacity * 2) : 256;
+
+		GLCDrawCommand *commands = (GLCDrawCommand*) realloc(queue->commands, capacity * sizeof(GLCDrawCommand));
+
+		if (!commands)
+			return 0;
+
+		queue->commands = commands;
+
+		GLCDrawSortItem *items = (GLCDrawSortItem*) realloc(queue->items, capacity * sizeof(GLCDrawSortItem));
+
+		if (!items)
+			return 0;
+
+		queue->items = items;
+
+		GLCDrawSortItem *scratch = (GLCDrawSortItem*) realloc(queue->scratch, capacity * sizeof(GLCDrawSortItem));
+
+		if (!scratch)
+			return 0;
+
+		queue->scratch = scratch;
+		queue->capacity = capacity;
+	}
+
+	queue->commands[queue->count] = *command;
+
+	queue->items[queue->count].key = command->key;
+	queue->items[queue->count].index = (uint32_t) queue->count;
+
+	++queue->count;
+
+	return 1;
+}
+
+// Stable LSD radix sort of the keys, a byte per pass. Bytes that are the
+// same for every key, like unused passes, skip their pass
+void glcDrawQueueSort(GLCDrawQueue *queue)
+{
+	const size_t count = queue->count;
+
+	queue->stats.skippedPasses = 0;
+
+	if (count < 2)
+		return;
+
+	size_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint64_t key = queue->items[i].key;
+
+		for (int pass = 0; pass < 8; ++pass)
+			++histograms[pass][(key >> (pass * 8)) & 0xFF];
+	}
+
+	GLCDrawSortItem *source = queue->items;
+	GLCDrawSortItem *destination = queue->scratch;
+
+	for (int pass = 0; pass < 8; ++pass)
+	{
+		size_t *histogram = histograms[pass];
+
+		if (histogram[(source[0].key >> (pass * 8)) & 0xFF] == count)
+		{
+			++queue->stats.skippedPasses;
+			continue;
+		}
+
+		size_t offset = 0;
+
+		for (int bucket = 0; bucket < 256; ++bucket)
+		{
+			const size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+			destination[histogram[(source[i].key >> (pass * 8)) & 0xFF]++] = source[i];
+
+		GLCDrawSortItem *swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	// An odd number of passes leaves the result in the scratch buffer
+	if (source != queue->items)
+	{
+		queue->scratch = queue->items;
+		queue->items = source;
+	}
+}
+
+void glcDrawQueueCountChanges(const GLCDrawQueue *queue, int sorted, unsigned int *programChanges, unsigned int *vertexArrayChanges, unsigned int *materialChanges)
+{
+	*programChanges = *vertexArrayChanges = *materialChanges = 0;
+
+	for (size_t i = 0; i < queue->count; ++i)
+	{
+		const GLCDrawCommand *command = queue->commands + (sorted ? queue->items[i].index : i);
+		const GLCDrawCommand *previous = (i > 0) ? (queue->commands + (sorted ? queue->items[i - 1].index : (i - 1))) : NULL;
+
+		*programChanges += !previous || (previous->program != command->program);
+		*vertexArrayChanges += !previous || (previous->vertexArray != command->vertexArray);
+		*materialChanges += !previous || (previous->material != command->material);
+	}
+}
+
+// Sorts and issues every draw through the state cache. bindMaterial may be NULL
+void glcDrawQueueSubmit(GLCDrawQueue *queue, GLCStateCache *state, GLCBindMaterial bindMaterial = NULL, void *user = NULL)
+{
+	glcDrawQueueSort(queue);
+
+	GLCDrawQueueStats *stats = &queue->stats;
+	stats->draws = (unsigned int) queue->count;
+
+	glcDrawQueueCountChanges(queue, 0, &stats->unsortedProgramChanges, &stats->unsortedVertexArrayChanges, &stats->unsortedMaterialChanges);
+	glcDrawQueueCountChanges(queue, 1, &stats->programChanges, &stats->vertexArrayChanges, &stats->materialChanges);
+
+	uint32_t material = 0;
+
+	for (size_t i = 0; i < queue->count; ++i)
+	{
+		const GLCDrawCommand *command = queue->commands + queue->items[i].index;
+
+		glcStateUseProgram(state, command->program);
+		glcStateBindVertexArray(state, command->vertexArray);
+
+		if (bindMaterial && ((i == 0) || (command->material != material)))
+			bindMaterial(state, command->material, user);
+
+		material = command->material;
+
+		if (command->uniformSize)
+			glcStateBindUniformBuffer(state, command->uniformBinding, command->uniformBuffer, command->uniformOffset, command->uniformSize);
+
+		if (command->indexType)
+			glDrawElements(command->mode, command->count, command->indexType, command->indices);
+		else
+			glDrawArrays(command->mode, command->first, command->count);
+	}
+}
+
+void glcDrawQueuePrintStats(const GLCDrawQueue *queue)
+{
+	const GLCDrawQueueStats *stats = &queue->stats;
+
+	printf("Draw Queue: %u draws, program changes %u (%u unsorted), vertex array changes %u (%u unsorted), material changes %u (%u unsorted), %u/8 radix passes skipped\n",
+	       stats->draws, stats->programChanges, stats->unsortedProgramChanges, stats->vertexArrayChanges, stats->unsortedVertexArrayChanges,
+	       stats->materialChanges, stats->unsortedMaterialChanges, stats->skippedPasses);
+}
+
+#endif
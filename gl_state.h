@@ -0,0 +1,418 @@
+#ifndef GLC_GL_STATE_H
+#define GLC_GL_STATE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+
+#define GLC_STATE_TEXTURE_UNITS   32
+#define GLC_STATE_UNIFORM_BINDINGS 16
+
+// Cached names are unknown until first set, such that the first call is
+// always issued
+#define GLC_STATE_UNKNOWN 0xFFFFFFFFu
+
+typedef enum GLCStateBufferTarget
+{
+	GLC_STATE_ARRAY_BUFFER,
+	GLC_STATE_ELEMENT_ARRAY_BUFFER,
+	GLC_STATE_UNIFORM_BUFFER,
+	GLC_STATE_COPY_READ_BUFFER,
+	GLC_STATE_COPY_WRITE_BUFFER,
+	GLC_STATE_PIXEL_PACK_BUFFER,
+	GLC_STATE_PIXEL_UNPACK_BUFFER,
+	GLC_STATE_TEXTURE_BUFFER,
+	GLC_STATE_DRAW_INDIRECT_BUFFER,
+
+	GLC_STATE_BUFFER_TARGET_COUNT
+} GLCStateBufferTarget;
+
+typedef enum GLCStateTextureTarget
+{
+	GLC_STATE_TEXTURE_1D,
+	GLC_STATE_TEXTURE_2D,
+	GLC_STATE_TEXTURE_3D,
+	GLC_STATE_TEXTURE_CUBE_MAP,
+	GLC_STATE_TEXTURE_1D_ARRAY,
+	GLC_STATE_TEXTURE_2D_ARRAY,
+	GLC_STATE_TEXTURE_RECTANGLE,
+	GLC_STATE_TEXTURE_2D_MULTISAMPLE,
+
+	GLC_STATE_TEXTURE_TARGET_COUNT
+} GLCStateTextureTarget;
+
+typedef struct GLCStateStats
+{
+	// Calls that reached GL, and calls skipped as they would not change anything
+	unsigned long long issued, filtered;
+} GLCStateStats;
+
+typedef struct GLCStateUniformBinding
+{
+	GLuint buffer;
+	GLintptr offset;
+	GLsizeiptr size;
+} GLCStateUniformBinding;
+
+// Shadows the GL state set through it. Anything changed with GL directly
+// must be followed by glcStateInvalidate
+typedef struct GLCStateCache
+{
+	GLuint program;
+	GLuint vertexArray;
+
+	GLuint buffers[GLC_STATE_BUFFER_TARGET_COUNT];
+	GLCStateUniformBinding uniformBindings[GLC_STATE_UNIFORM_BINDINGS];
+
+	GLenum activeTexture;
+	GLuint textures[GLC_STATE_TEXTURE_UNITS][GLC_STATE_TEXTURE_TARGET_COUNT];
+
+	GLint viewport[4], scissor[4];
+	int viewportKnown, scissorKnown;
+
+	// A bit per capability, see glcStateCapabilityBit
+	uint32_t capabilitiesKnown, capabilitiesEnabled;
+
+	GLCStateStats stats;
+} GLCStateCache;
+
+// Forgets all cached state, keeping the stats
+void glcStateInvalidate(GLCStateCache *state)
+{
+	const GLCStateStats stats = state->stats;
+
+	// Every name becomes GLC_STATE_UNKNOWN
+	memset(state, 0xFF, sizeof(GLCStateCache));
+
+	state->activeTexture = GL_NONE;
+	state->viewportKnown = state->scissorKnown = 0;
+	state->capabilitiesKnown = state->capabilitiesEnabled = 0;
+
+	state->stats = stats;
+}
+
+void glcStateInit(GLCStateCache *state)
+{
+	memset(&state->stats, 0, sizeof(GLCStateStats));
+
+	glcStateInvalidate(state);
+}
+
+int glcStateBufferTarget(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:
+		return GLC_STATE_ARRAY_BUFFER;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		return GLC_STATE_ELEMENT_ARRAY_BUFFER;
+	case GL_UNIFORM_BUFFER:
+		return GLC_STATE_UNIFORM_BUFFER;
+	case GL_COPY_READ_BUFFER:
+		return GLC_STATE_COPY_READ_BUFFER;
+	case GL_COPY_WRITE_BUFFER:
+		return GLC_STATE_COPY_WRITE_BUFFER;
+	case GL_PIXEL_PACK_BUFFER:
+		return GLC_STATE_PIXEL_PACK_BUFFER;
+	case GL_PIXEL_UNPACK_BUFFER:
+		return GLC_STATE_PIXEL_UNPACK_BUFFER;
+	case GL_TEXTURE_BUFFER:
+		return GLC_STATE_TEXTURE_BUFFER;
+	case GL_DRAW_INDIRECT_BUFFER:
+		return GLC_STATE_DRAW_INDIRECT_BUFFER;
+	default:
+		return -1;
+	}
+}
+
+int glcStateTextureTarget(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_1D:
+		return GLC_STATE_TEXTURE_1D;
+	case GL_TEXTURE_2D:
+		return GLC_STATE_TEXTURE_2D;
+	case GL_TEXTURE_3D:
+		return GLC_STATE_TEXTURE_3D;
+	case GL_TEXTURE_CUBE_MAP:
+		return GLC_STATE_TEXTURE_CUBE_MAP;
+	case GL_TEXTURE_1D_ARRAY:
+		return GLC_STATE_TEXTURE_1D_ARRAY;
+	case GL_TEXTURE_2D_ARRAY:
+		return GLC_STATE_TEXTURE_2D_ARRAY;
+	case GL_TEXTURE_RECTANGLE:
+		return GLC_STATE_TEXTURE_RECTANGLE;
+	case GL_TEXTURE_2D_MULTISAMPLE:
+		return GLC_STATE_TEXTURE_2D_MULTISAMPLE;
+	default:
+		return -1;
+	}
+}
+
+// Returns 0 for capabilities that are not cached
+uint32_t glcStateCapabilityBit(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_BLEND:
+		return 1u << 0;
+	case GL_CULL_FACE:
+		return 1u << 1;
+	case GL_DEPTH_TEST:
+		return 1u << 2;
+	case GL_STENCIL_TEST:
+		return 1u << 3;
+	case GL_SCISSOR_TEST:
+		return 1u << 4;
+	case GL_POLYGON_OFFSET_FILL:
+		return 1u << 5;
+	case GL_MULTISAMPLE:
+		return 1u << 6;
+	case GL_FRAMEBUFFER_SRGB:
+		return 1u << 7;
+	case GL_PROGRAM_POINT_SIZE:
+		return 1u << 8;
+	case GL_DEPTH_CLAMP:
+		return 1u << 9;
+	case GL_PRIMITIVE_RESTART:
+		return 1u << 10;
+	case GL_RASTERIZER_DISCARD:
+		return 1u << 11;
+	case GL_TEXTURE_CUBE_MAP_SEAMLESS:
+		return 1u << 12;
+	default:
+		return 0;
+	}
+}
+
+// Returns 1 if the call has to be issued, counting it either way
+int glcStateChanged(GLCStateCache *state, int changed)
+{
+	if (changed)
+		++state->stats.issued;
+	else
+		++state->stats.filtered;
+
+	return changed;
+}
+
+void glcStateUseProgram(GLCStateCache *state, GLuint program)
+{
+	if (glcStateChanged(state, state->program != program))
+	{
+		state->program = program;
+		glUseProgram(program);
+	}
+}
+
+void glcStateBindVertexArray(GLCStateCache *state, GLuint vertexArray)
+{
+	if (glcStateChanged(state, state->vertexArray != vertexArray))
+	{
+		state->vertexArray = vertexArray;
+		glBindVertexArray(vertexArray);
+
+		// The element array binding is part of the vertex array
+		state->buffers[GLC_STATE_ELEMENT_ARRAY_BUFFER] = GLC_STATE_UNKNOWN;
+	}
+}
+
+void glcStateBindBuffer(GLCStateCache *state, GLenum target, GLuint buffer)
+{
+	const int index = glcStateBufferTarget(target);
+
+	if (index == -1)
+	{
+		glcStateChanged(state, 1);
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (glcStateChanged(state, state->buffers[index] != buffer))
+	{
+		state->buffers[index] = buffer;
+		glBindBuffer(target, buffer);
+	}
+}
+
+// Binds a range of buffer to a uniform block binding point, which also
+// binds it to GL_UNIFORM_BUFFER
+void glcStateBindUniformBuffer(GLCStateCache *state, GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	if (binding >= GLC_STATE_UNIFORM_BINDINGS)
+	{
+		glcStateChanged(state, 1);
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+		state->buffers[GLC_STATE_UNIFORM_BUFFER] = buffer;
+		return;
+	}
+
+	GLCStateUniformBinding *cached = state->uniformBindings + binding;
+
+	if (glcStateChanged(state, (cached->buffer != buffer) || (cached->offset != offset) || (cached->size != size)))
+	{
+		cached->buffer = buffer;
+		cached->offset = offset;
+		cached->size = size;
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+		state->buffers[GLC_STATE_UNIFORM_BUFFER] = buffer;
+	}
+}
+
+void glcStateActiveTexture(GLCStateCache *state, GLenum unit)
+{
+	if (glcStateChanged(state, state->activeTexture != unit))
+	{
+		state->activeTexture = unit;
+		glActiveTexture(unit);
+	}
+}
+
+// unit is an index, not GL_TEXTUREi. Only changes the active texture unit
+// if the binding changes
+void glcStateBindTexture(GLCStateCache *state, GLuint unit, GLenum target, GLuint texture)
+{
+	const int index = glcStateTextureTarget(target);
+
+	if ((index == -1) || (unit >= GLC_STATE_TEXTURE_UNITS))
+	{
+		glcStateActiveTexture(state, GL_TEXTURE0 + unit);
+		glcStateChanged(state, 1);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (glcStateChanged(state, state->textures[unit][index] != texture))
+	{
+		glcStateActiveTexture(state, GL_TEXTURE0 + unit);
+
+		state->textures[unit][index] = texture;
+		glBindTexture(target, texture);
+	}
+}
+
+void glcStateViewport(GLCStateCache *state, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	const GLint viewport[4] = { x, y, width, height };
+
+	if (glcStateChanged(state, !state->viewportKnown || (memcmp(state->viewport, viewport, sizeof(viewport)) != 0)))
+	{
+		memcpy(state->viewport, viewport, sizeof(viewport));
+		state->viewportKnown = 1;
+
+		glViewport(x, y, width, height);
+	}
+}
+
+void glcStateScissor(GLCStateCache *state, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	const GLint scissor[4] = { x, y, width, height };
+
+	if (glcStateChanged(state, !state->scissorKnown || (memcmp(state->scissor, scissor, sizeof(scissor)) != 0)))
+	{
+		memcpy(state->scissor, scissor, sizeof(scissor));
+		state->scissorKnown = 1;
+
+		glScissor(x, y, width, height);
+	}
+}
+
+void glcStateSetCapability(GLCStateCache *state, GLenum capability, int enabled)
+{
+	const uint32_t bit = glcStateCapabilityBit(capability);
+	const uint32_t value = enabled ? bit : 0;
+
+	if (glcStateChanged(state, !(state->capabilitiesKnown & bit) || ((state->capabilitiesEnabled & bit) != value)))
+	{
+		state->capabilitiesKnown |= bit;
+		state->capabilitiesEnabled = (state->capabilitiesEnabled & ~bit) | value;
+
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+}
+
+void glcStateEnable(GLCStateCache *state, GLenum capability)
+{
+	glcStateSetCapability(state, capability, 1);
+}
+
+void glcStateDisable(GLCStateCache *state, GLenum capability)
+{
+	glcStateSetCapability(state, capability, 0);
+}
+
+// Deleting through the cache forgets the names, as GL may hand them out again
+
+void glcStateDeleteProgram(GLCStateCache *state, GLuint program)
+{
+	if (state->program == program)
+		state->program = GLC_STATE_UNKNOWN;
+
+	glDeleteProgram(program);
+}
+
+void glcStateDeleteVertexArrays(GLCStateCache *state, GLsizei count, const GLuint *vertexArrays)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (state->vertexArray == vertexArrays[i])
+			state->vertexArray = GLC_STATE_UNKNOWN;
+	}
+
+	glDeleteVertexArrays(count, vertexArrays);
+}
+
+void glcStateDeleteBuffers(GLCStateCache *state, GLsizei count, const GLuint *buffers)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (int target = 0; target < GLC_STATE_BUFFER_TARGET_COUNT; ++target)
+		{
+			if (state->buffers[target] == buffers[i])
+				state->buffers[target] = GLC_STATE_UNKNOWN;
+		}
+
+		for (int binding = 0; binding < GLC_STATE_UNIFORM_BINDINGS; ++binding)
+		{
+			if (state->uniformBindings[binding].buffer == buffers[i])
+				state->uniformBindings[binding].buffer = GLC_STATE_UNKNOWN;
+		}
+	}
+
+	glDeleteBuffers(count, buffers);
+}
+
+void glcStateDeleteTextures(GLCStateCache *state, GLsizei count, const GLuint *textures)
+{
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		for (int unit = 0; unit < GLC_STATE_TEXTURE_UNITS; ++unit)
+		{
+			for (int target = 0; target < GLC_STATE_TEXTURE_TARGET_COUNT; ++target)
+			{
+				if (state->textures[unit][target] == textures[i])
+					state->textures[unit][target] = GLC_STATE_UNKNOWN;
+			}
+		}
+	}
+
+	glDeleteTextures(count, textures);
+}
+
+void glcStatePrintStats(const GLCStateCache *state)
+{
+	const GLCStateStats *stats = &state->stats;
+	const unsigned long long total = stats->issued + stats->filtered;
+
+	printf("State Cache: %llu issued, %llu filtered (%.1f%% of %llu calls)\n",
+	       stats->issued, stats->filtered, total ? (100.0 * (double) stats->filtered / (double) total) : 0.0, total);
+}
+
+#endif
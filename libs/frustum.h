@@ -0,0 +1,364 @@
+#ifndef GLC_FRUSTUM_H
+#define GLC_FRUSTUM_H
+
+#include "linmath.h"
+
+enum
+{
+	GLC_FRUSTUM_LEFT,
+	GLC_FRUSTUM_RIGHT,
+	GLC_FRUSTUM_BOTTOM,
+	GLC_FRUSTUM_TOP,
+	GLC_FRUSTUM_NEAR,
+	GLC_FRUSTUM_FAR,
+	GLC_FRUSTUM_PLANE_COUNT,
+};
+
+// Planes are (a, b, c, d) with normalized (a, b, c) pointing inwards, such
+// that a point is inside when a * x + b * y + c * z + d >= 0
+typedef struct GLCFrustum
+{
+	float planes[GLC_FRUSTUM_PLANE_COUNT][4];
+} GLCFrustum;
+
+// Extracts the planes from a projection * view matrix, yielding world space
+// planes, or from a projection matrix alone, yielding view space planes
+void frustumFromMatrix(GLCFrustum *frustum, const float m[16])
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		const float row0 = m[i * 4 + 0], row1 = m[i * 4 + 1];
+		const float row2 = m[i * 4 + 2], row3 = m[i * 4 + 3];
+
+		frustum->planes[GLC_FRUSTUM_LEFT][i] = row3 + row0;
+		frustum->planes[GLC_FRUSTUM_RIGHT][i] = row3 - row0;
+		frustum->planes[GLC_FRUSTUM_BOTTOM][i] = row3 + row1;
+		frustum->planes[GLC_FRUSTUM_TOP][i] = row3 - row1;
+		frustum->planes[GLC_FRUSTUM_NEAR][i] = row3 + row2;
+		frustum->planes[GLC_FRUSTUM_FAR][i] = row3 - row2;
+	}
+
+	for (int i = 0; i < GLC_FRUSTUM_PLANE_COUNT; ++i)
+	{
+		float *plane = frustum->planes[i];
+
+		const float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+		if (length == 0.0f)
+			continue;
+
+		const float invLength = 1.0f / length;
+
+		for (int j = 0; j < 4; ++j)
+			plane[j] *= invLength;
+	}
+}
+
+// World space planes of mat4Perspective(fov, aspect, zNear, zFar) * view
+void frustumFromPerspectiveView(GLCFrustum *frustum, float fov, float aspect, float zNear, float zFar, const float view[16])
+{
+	float viewProjection[16];
+	mat4PerspectiveMultiply(viewProjection, fov, aspect, zNear, zFar, view);
+
+	frustumFromMatrix(frustum, viewProjection);
+}
+
+int frustumTestSphere(const GLCFrustum *frustum, float x, float y, float z, float radius)
+{
+	for (int i = 0; i < GLC_FRUSTUM_PLANE_COUNT; ++i)
+	{
+		const float *plane = frustum->planes[i];
+
+		if ((plane[0] * x + plane[1] * y + plane[2] * z + plane[3]) < -radius)
+			return 0;
+	}
+
+	return 1;
+}
+
+// The box is given by its center and half extents
+int frustumTestAABB(const GLCFrustum *frustum, float cx, float cy, float cz, float ex, float ey, float ez)
+{
+	for (int i = 0; i < GLC_FRUSTUM_PLANE_COUNT; ++i)
+	{
+		const float *plane = frustum->planes[i];
+
+		const float distance = plane[0] * cx + plane[1] * cy + plane[2] * cz + plane[3];
+		const float radius = fabsf(plane[0]) * ex + fabsf(plane[1]) * ey + fabsf(plane[2]) * ez;
+
+		if (distance < -radius)
+			return 0;
+	}
+
+	return 1;
+}
+
+// Batches are structure-of-arrays, spheres as (x, y, z, radius) and boxes as
+// (cx, cy, cz, ex, ey, ez) arrays, given in this order by bounds. The
+// indices of the visible bounds are written in ascending order to visible,
+// which must hold count indices, and the visible count is returned
+
+typedef size_t (*GLCFrustumCullFunc)(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible);
+
+size_t frustumCullSpheresScalar(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestSphere(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i]);
+	}
+
+	return visibleCount;
+}
+
+size_t frustumCullAABBsScalar(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestAABB(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i], bounds[4][i], bounds[5][i]);
+	}
+
+	return visibleCount;
+}
+
+// Appends the indices of the set bits of mask, writing unconditionally and
+// only advancing past visible ones, which never writes beyond index + width
+size_t frustumCompactVisible(uint32_t *visible, size_t visibleCount, size_t index, int mask, int width)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		visible[visibleCount] = (uint32_t) (index + i);
+		visibleCount += (mask >> i) & 1;
+	}
+
+	return visibleCount;
+}
+
+#if defined(GLC_LINMATH_SSE2)
+size_t frustumCullSpheresSSE2(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0, i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(bounds[0] + i);
+		const __m128 y = _mm_loadu_ps(bounds[1] + i);
+		const __m128 z = _mm_loadu_ps(bounds[2] + i);
+		const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(bounds[3] + i));
+
+		__m128 outside = _mm_setzero_ps();
+
+		for (int p = 0; p < GLC_FRUSTUM_PLANE_COUNT; ++p)
+		{
+			const float *plane = frustum->planes[p];
+
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(plane[0]), x);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[1]), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[2]), z));
+			distance = _mm_add_ps(distance, _mm_set1_ps(plane[3]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+		}
+
+		visibleCount = frustumCompactVisible(visible, visibleCount, i, ~_mm_movemask_ps(outside) & 0xF, 4);
+	}
+
+	for (; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestSphere(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i]);
+	}
+
+	return visibleCount;
+}
+
+size_t frustumCullAABBsSSE2(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0, i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(bounds[0] + i);
+		const __m128 cy = _mm_loadu_ps(bounds[1] + i);
+		const __m128 cz = _mm_loadu_ps(bounds[2] + i);
+		const __m128 ex = _mm_loadu_ps(bounds[3] + i);
+		const __m128 ey = _mm_loadu_ps(bounds[4] + i);
+		const __m128 ez = _mm_loadu_ps(bounds[5] + i);
+
+		__m128 outside = _mm_setzero_ps();
+
+		for (int p = 0; p < GLC_FRUSTUM_PLANE_COUNT; ++p)
+		{
+			const float *plane = frustum->planes[p];
+
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(plane[0]), cx);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[1]), cy));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[2]), cz));
+			distance = _mm_add_ps(distance, _mm_set1_ps(plane[3]));
+
+			__m128 radius = _mm_mul_ps(_mm_set1_ps(fabsf(plane[0])), ex);
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(plane[1])), ey));
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(plane[2])), ez));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), radius)));
+		}
+
+		visibleCount = frustumCompactVisible(visible, visibleCount, i, ~_mm_movemask_ps(outside) & 0xF, 4);
+	}
+
+	for (; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestAABB(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i], bounds[4][i], bounds[5][i]);
+	}
+
+	return visibleCount;
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+size_t frustumCullSpheresAVX(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0, i = 0;
+
+	for (; (i + 8) <= count; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(bounds[0] + i);
+		const __m256 y = _mm256_loadu_ps(bounds[1] + i);
+		const __m256 z = _mm256_loadu_ps(bounds[2] + i);
+		const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(bounds[3] + i));
+
+		__m256 outside = _mm256_setzero_ps();
+
+		for (int p = 0; p < GLC_FRUSTUM_PLANE_COUNT; ++p)
+		{
+			const float *plane = frustum->planes[p];
+
+			__m256 distance = _mm256_mul_ps(_mm256_set1_ps(plane[0]), x);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[1]), y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[2]), z));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(plane[3]));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negRadius, _CMP_LT_OQ));
+		}
+
+		visibleCount = frustumCompactVisible(visible, visibleCount, i, ~_mm256_movemask_ps(outside) & 0xFF, 8);
+	}
+
+	// The scalar tail isn't compiled for AVX, avoid the SSE transition penalty
+	_mm256_zeroupper();
+
+	for (; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestSphere(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i]);
+	}
+
+	return visibleCount;
+}
+
+GLC_LINMATH_TARGET_AVX
+size_t frustumCullAABBsAVX(const GLCFrustum *frustum, const float *const *bounds, size_t count, uint32_t *visible)
+{
+	size_t visibleCount = 0, i = 0;
+
+	for (; (i + 8) <= count; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(bounds[0] + i);
+		const __m256 cy = _mm256_loadu_ps(bounds[1] + i);
+		const __m256 cz = _mm256_loadu_ps(bounds[2] + i);
+		const __m256 ex = _mm256_loadu_ps(bounds[3] + i);
+		const __m256 ey = _mm256_loadu_ps(bounds[4] + i);
+		const __m256 ez = _mm256_loadu_ps(bounds[5] + i);
+
+		__m256 outside = _mm256_setzero_ps();
+
+		for (int p = 0; p < GLC_FRUSTUM_PLANE_COUNT; ++p)
+		{
+			const float *plane = frustum->planes[p];
+
+			__m256 distance = _mm256_mul_ps(_mm256_set1_ps(plane[0]), cx);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[1]), cy));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[2]), cz));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(plane[3]));
+
+			__m256 radius = _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[0])), ex);
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[1])), ey));
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[2])), ez));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), radius), _CMP_LT_OQ));
+		}
+
+		visibleCount = frustumCompactVisible(visible, visibleCount, i, ~_mm256_movemask_ps(outside) & 0xFF, 8);
+	}
+
+	// The scalar tail isn't compiled for AVX, avoid the SSE transition penalty
+	_mm256_zeroupper();
+
+	for (; i < count; ++i)
+	{
+		visible[visibleCount] = (uint32_t) i;
+		visibleCount += frustumTestAABB(frustum, bounds[0][i], bounds[1][i], bounds[2][i], bounds[3][i], bounds[4][i], bounds[5][i]);
+	}
+
+	return visibleCount;
+}
+#endif
+
+GLCFrustumCullFunc frustumGetCullSpheresFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return frustumCullSpheresAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return frustumCullSpheresSSE2;
+#endif
+	default:
+		return frustumCullSpheresScalar;
+	}
+}
+
+GLCFrustumCullFunc frustumGetCullAABBsFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return frustumCullAABBsAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return frustumCullAABBsSSE2;
+#endif
+	default:
+		return frustumCullAABBsScalar;
+	}
+}
+
+size_t frustumCullSpheres(const GLCFrustum *frustum, const float *x, const float *y, const float *z, const float *radius, size_t count, uint32_t *visible)
+{
+	static const GLCFrustumCullFunc cull = frustumGetCullSpheresFunc(linmathGetSIMDLevel());
+
+	const float *const bounds[4] = { x, y, z, radius };
+	return cull(frustum, bounds, count, visible);
+}
+
+size_t frustumCullAABBs(const GLCFrustum *frustum, const float *cx, const float *cy, const float *cz, const float *ex, const float *ey, const float *ez, size_t count, uint32_t *visible)
+{
+	static const GLCFrustumCullFunc cull = frustumGetCullAABBsFunc(linmathGetSIMDLevel());
+
+	const float *const bounds[6] = { cx, cy, cz, ex, ey, ez };
+	return cull(frustum, bounds, count, visible);
+}
+
+#endif
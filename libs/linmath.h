@@ -1,14 +1,100 @@
 #ifndef GLC_LINMATH_H
 #define GLC_LINMATH_H
 
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
 
+#if !defined(GLC_LINMATH_NO_SIMD)
+#	if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#		define GLC_LINMATH_SSE2 1
+#		define GLC_LINMATH_AVX 1
+#		include <immintrin.h>
+#		if defined(_MSC_VER)
+#			include <intrin.h>
+#		endif
+#	elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#		define GLC_LINMATH_NEON 1
+#		include <arm_neon.h>
+#	endif
+#endif
+
+// AVX kernels are compiled for AVX regardless of the global target flags,
+// and only ever called after the CPU has been checked for AVX support
+#if defined(GLC_LINMATH_AVX) && (defined(__GNUC__) || defined(__clang__))
+#	define GLC_LINMATH_TARGET_AVX __attribute__((target("avx")))
+#else
+#	define GLC_LINMATH_TARGET_AVX
+#endif
+
 #define GLC_PI 3.14159265358979323846f
 
 #define GLC_RAD(degrees) ((degrees) * GLC_PI / 180.0f)
 
+typedef enum GLCSIMDLevel
+{
+	GLC_SIMD_SCALAR,
+	GLC_SIMD_SSE2,
+	GLC_SIMD_AVX,
+	GLC_SIMD_NEON,
+} GLCSIMDLevel;
+
+const char* linmathGetSIMDLevelString(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+	case GLC_SIMD_SCALAR:
+		return "Scalar";
+	case GLC_SIMD_SSE2:
+		return "SSE2";
+	case GLC_SIMD_AVX:
+		return "AVX";
+	case GLC_SIMD_NEON:
+		return "NEON";
+	default:
+		return "Unknown";
+	}
+}
+
+GLCSIMDLevel linmathDetectSIMDLevel()
+{
+#if defined(GLC_LINMATH_AVX) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx"))
+		return GLC_SIMD_AVX;
+
+	return GLC_SIMD_SSE2;
+#elif defined(GLC_LINMATH_AVX) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+
+	// The OS must also save the YMM registers on context switches
+	if (osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6))
+		return GLC_SIMD_AVX;
+
+	return GLC_SIMD_SSE2;
+#elif defined(GLC_LINMATH_SSE2)
+	return GLC_SIMD_SSE2;
+#elif defined(GLC_LINMATH_NEON)
+	return GLC_SIMD_NEON;
+#else
+	return GLC_SIMD_SCALAR;
+#endif
+}
+
+// Detected once, every dispatched function selects its kernel from this
+GLCSIMDLevel linmathGetSIMDLevel()
+{
+	static const GLCSIMDLevel level = linmathDetectSIMDLevel();
+	return level;
+}
+
 void mat4Identity(float matrix[16])
 {
 	const float identity[16] = {
@@ -21,19 +107,564 @@ void mat4Identity(float matrix[16])
 	memcpy(matrix, identity, sizeof(identity));
 }
 
-void mat4Multiply(float matrix[16], const float lhs[16], const float rhs[16])
+// Polynomial sine and cosine, with a max absolute error of 2e-7 for
+// |angle| <= GLC_SINCOS_MAX_ANGLE (see linmath_bench). Larger angles, and
+// NaN and infinities, go through sinf and cosf, as the reduction loses
+// precision and the quadrant no longer fits an int. The angle is reduced to
+// [-pi/4, pi/4] around the nearest multiple of pi/2, where minimax
+// polynomials approximate both functions.
+// One angle at a time this is no faster than sinf and cosf, it is the
+// reference and tail of linmathSinCosBatch, which is where the speedup is
+
+#define GLC_SINCOS_MAX_ANGLE 8192.0f
+
+#define GLC_PIO2_1 1.5703125f
+#define GLC_PIO2_2 4.837512969970703125e-4f
+#define GLC_PIO2_3 7.54978995489188216e-8f
+
+#define GLC_SIN_C0 -1.9515295891e-4f
+#define GLC_SIN_C1  8.3321608736e-3f
+#define GLC_SIN_C2 -1.6666654611e-1f
+
+#define GLC_COS_C0  2.443315711809948e-5f
+#define GLC_COS_C1 -1.388731625493765e-3f
+#define GLC_COS_C2  4.166664568298827e-2f
+
+void linmathSinCos(float angle, float *s, float *c)
+{
+	// Written such that NaN fails it too
+	if (!(fabsf(angle) <= GLC_SINCOS_MAX_ANGLE))
+	{
+		*s = sinf(angle);
+		*c = cosf(angle);
+		return;
+	}
+
+	// floor(x + 0.5) through truncation, which unlike floorf is never a call
+	const float scaled = angle * (2.0f / GLC_PI) + 0.5f;
+
+	int quadrant = (int) scaled;
+	if ((float) quadrant > scaled)
+		--quadrant;
+
+	const float q = (float) quadrant;
+
+	// Subtracting pi/2 in three parts keeps the reduction exact
+	const float r = ((angle - q * GLC_PIO2_1) - q * GLC_PIO2_2) - q * GLC_PIO2_3;
+	const float r2 = r * r;
+
+	const float sr = ((GLC_SIN_C0 * r2 + GLC_SIN_C1) * r2 + GLC_SIN_C2) * r2 * r + r;
+	const float cr = ((GLC_COS_C0 * r2 + GLC_COS_C1) * r2 + GLC_COS_C2) * r2 * r2 - 0.5f * r2 + 1.0f;
+
+	// Selects and negates through the bits like the SIMD kernels, as branches
+	// on the quadrant mispredict for varying angles
+	uint32_t srBits, crBits;
+	memcpy(&srBits, &sr, sizeof(srBits));
+	memcpy(&crBits, &cr, sizeof(crBits));
+
+	const uint32_t swap = 0u - ((uint32_t) quadrant & 1u);
+
+	const uint32_t sinBits = ((crBits & swap) | (srBits & ~swap)) ^ (((uint32_t) quadrant & 2u) << 30);
+	const uint32_t cosBits = ((srBits & swap) | (crBits & ~swap)) ^ (((uint32_t) (quadrant + 1) & 2u) << 30);
+
+	memcpy(s, &sinBits, sizeof(sinBits));
+	memcpy(c, &cosBits, sizeof(cosBits));
+}
+
+typedef void (*GLCSinCosBatchFunc)(const float *angles, float *s, float *c, size_t count);
+
+void linmathSinCosBatchScalar(const float *angles, float *s, float *c, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		linmathSinCos(angles[i], s + i, c + i);
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void linmathSinCosBatchSSE2(const float *angles, float *s, float *c, size_t count)
 {
+	const __m128 twoOverPi = _mm_set1_ps(2.0f / GLC_PI);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i oneBit = _mm_set1_epi32(1);
+	const __m128i twoBit = _mm_set1_epi32(2);
+	const __m128 maxAngle = _mm_set1_ps(GLC_SINCOS_MAX_ANGLE);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	size_t i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128 angle = _mm_loadu_ps(angles + i);
+
+		// Out of range angles take the scalar fallback, like linmathSinCos
+		if (_mm_movemask_ps(_mm_cmple_ps(_mm_and_ps(angle, absMask), maxAngle)) != 0xF)
+		{
+			linmathSinCosBatchScalar(angles + i, s + i, c + i, 4);
+			continue;
+		}
+
+		// floor(x + 0.5) through truncation, corrected for negative values
+		const __m128 scaled = _mm_add_ps(_mm_mul_ps(angle, twoOverPi), half);
+		__m128i quadrant = _mm_cvttps_epi32(scaled);
+		__m128 q = _mm_cvtepi32_ps(quadrant);
+
+		const __m128 correction = _mm_cmpgt_ps(q, scaled);
+		q = _mm_sub_ps(q, _mm_and_ps(correction, one));
+		quadrant = _mm_add_epi32(quadrant, _mm_castps_si128(correction));
+
+		__m128 r = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(GLC_PIO2_1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(GLC_PIO2_2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(GLC_PIO2_3)));
+
+		const __m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 sr = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(GLC_SIN_C0), r2), _mm_set1_ps(GLC_SIN_C1));
+		sr = _mm_add_ps(_mm_mul_ps(sr, r2), _mm_set1_ps(GLC_SIN_C2));
+		sr = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sr, r2), r), r);
+
+		__m128 cr = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(GLC_COS_C0), r2), _mm_set1_ps(GLC_COS_C1));
+		cr = _mm_add_ps(_mm_mul_ps(cr, r2), _mm_set1_ps(GLC_COS_C2));
+		cr = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cr, r2), r2), _mm_mul_ps(half, r2));
+		cr = _mm_add_ps(cr, one);
+
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, oneBit), oneBit));
+
+		const __m128 sinValue = _mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr));
+		const __m128 cosValue = _mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr));
+
+		// Bit 1 of the quadrant shifted into the sign bit
+		const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, twoBit), 30));
+		const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, oneBit), twoBit), 30));
+
+		_mm_storeu_ps(s + i, _mm_xor_ps(sinValue, sinSign));
+		_mm_storeu_ps(c + i, _mm_xor_ps(cosValue, cosSign));
+	}
+
+	linmathSinCosBatchScalar(angles + i, s + i, c + i, count - i);
+}
+#endif
+
+GLCSinCosBatchFunc linmathGetSinCosBatchFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_AVX:
+	case GLC_SIMD_SSE2:
+		return linmathSinCosBatchSSE2;
+#endif
+	default:
+		return linmathSinCosBatchScalar;
+	}
+}
+
+void linmathSinCosBatch(const float *angles, float *s, float *c, size_t count)
+{
+	static const GLCSinCosBatchFunc sincos = linmathGetSinCosBatchFunc(linmathGetSIMDLevel());
+	sincos(angles, s, c, count);
+}
+
+typedef void (*GLCMat4MultiplyFunc)(float matrix[16], const float lhs[16], const float rhs[16]);
+
+// Reference implementation, the SIMD kernels below evaluate the exact same
+// sequence of multiplies and adds, so their results are bit-identical
+void mat4MultiplyScalar(float matrix[16], const float lhs[16], const float rhs[16])
+{
+	float result[16];
+
 	for (int i = 0; i < 4; ++i)
 	{
 		for (int j = 0; j < 4; ++j)
 		{
-			matrix[i * 4 + j] =
+			result[i * 4 + j] =
 					lhs[j + 0 * 4] * rhs[i * 4 + 0] +
 					lhs[j + 1 * 4] * rhs[i * 4 + 1] +
 					lhs[j + 2 * 4] * rhs[i * 4 + 2] +
 					lhs[j + 3 * 4] * rhs[i * 4 + 3];
 		}
 	}
+
+	memcpy(matrix, result, sizeof(result));
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void mat4MultiplySSE2(float matrix[16], const float lhs[16], const float rhs[16])
+{
+	const __m128 c0 = _mm_loadu_ps(lhs + 0);
+	const __m128 c1 = _mm_loadu_ps(lhs + 4);
+	const __m128 c2 = _mm_loadu_ps(lhs + 8);
+	const __m128 c3 = _mm_loadu_ps(lhs + 12);
+
+	__m128 columns[4];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const __m128 r = _mm_loadu_ps(rhs + i * 4);
+
+		__m128 column = _mm_mul_ps(c0, _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0)));
+		column = _mm_add_ps(column, _mm_mul_ps(c1, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1))));
+		column = _mm_add_ps(column, _mm_mul_ps(c2, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2))));
+		column = _mm_add_ps(column, _mm_mul_ps(c3, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3))));
+
+		columns[i] = column;
+	}
+
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_ps(matrix + i * 4, columns[i]);
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+// Computes two result columns per iteration, lhs is broadcast to both lanes
+GLC_LINMATH_TARGET_AVX
+void mat4MultiplyAVX(float matrix[16], const float lhs[16], const float rhs[16])
+{
+	const __m256 c0 = _mm256_broadcast_ps((const __m128*) (lhs + 0));
+	const __m256 c1 = _mm256_broadcast_ps((const __m128*) (lhs + 4));
+	const __m256 c2 = _mm256_broadcast_ps((const __m128*) (lhs + 8));
+	const __m256 c3 = _mm256_broadcast_ps((const __m128*) (lhs + 12));
+
+	const __m256 r01 = _mm256_loadu_ps(rhs + 0);
+	const __m256 r23 = _mm256_loadu_ps(rhs + 8);
+
+	__m256 m01 = _mm256_mul_ps(c0, _mm256_permute_ps(r01, _MM_SHUFFLE(0, 0, 0, 0)));
+	m01 = _mm256_add_ps(m01, _mm256_mul_ps(c1, _mm256_permute_ps(r01, _MM_SHUFFLE(1, 1, 1, 1))));
+	m01 = _mm256_add_ps(m01, _mm256_mul_ps(c2, _mm256_permute_ps(r01, _MM_SHUFFLE(2, 2, 2, 2))));
+	m01 = _mm256_add_ps(m01, _mm256_mul_ps(c3, _mm256_permute_ps(r01, _MM_SHUFFLE(3, 3, 3, 3))));
+
+	__m256 m23 = _mm256_mul_ps(c0, _mm256_permute_ps(r23, _MM_SHUFFLE(0, 0, 0, 0)));
+	m23 = _mm256_add_ps(m23, _mm256_mul_ps(c1, _mm256_permute_ps(r23, _MM_SHUFFLE(1, 1, 1, 1))));
+	m23 = _mm256_add_ps(m23, _mm256_mul_ps(c2, _mm256_permute_ps(r23, _MM_SHUFFLE(2, 2, 2, 2))));
+	m23 = _mm256_add_ps(m23, _mm256_mul_ps(c3, _mm256_permute_ps(r23, _MM_SHUFFLE(3, 3, 3, 3))));
+
+	_mm256_storeu_ps(matrix + 0, m01);
+	_mm256_storeu_ps(matrix + 8, m23);
+}
+#endif
+
+#if defined(GLC_LINMATH_NEON)
+void mat4MultiplyNEON(float matrix[16], const float lhs[16], const float rhs[16])
+{
+	const float32x4_t c0 = vld1q_f32(lhs + 0);
+	const float32x4_t c1 = vld1q_f32(lhs + 4);
+	const float32x4_t c2 = vld1q_f32(lhs + 8);
+	const float32x4_t c3 = vld1q_f32(lhs + 12);
+
+	float32x4_t columns[4];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const float *r = rhs + i * 4;
+
+		float32x4_t column = vmulq_n_f32(c0, r[0]);
+		column = vaddq_f32(column, vmulq_n_f32(c1, r[1]));
+		column = vaddq_f32(column, vmulq_n_f32(c2, r[2]));
+		column = vaddq_f32(column, vmulq_n_f32(c3, r[3]));
+
+		columns[i] = column;
+	}
+
+	for (int i = 0; i < 4; ++i)
+		vst1q_f32(matrix + i * 4, columns[i]);
+}
+#endif
+
+GLCMat4MultiplyFunc mat4GetMultiplyFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return mat4MultiplyAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return mat4MultiplySSE2;
+#endif
+#if defined(GLC_LINMATH_NEON)
+	case GLC_SIMD_NEON:
+		return mat4MultiplyNEON;
+#endif
+	default:
+		return mat4MultiplyScalar;
+	}
+}
+
+// matrix may alias lhs and/or rhs
+void mat4Multiply(float matrix[16], const float lhs[16], const float rhs[16])
+{
+	static const GLCMat4MultiplyFunc multiply = mat4GetMultiplyFunc(linmathGetSIMDLevel());
+	multiply(matrix, lhs, rhs);
+}
+
+typedef void (*GLCMat4MultiplyBatchFunc)(float *matrices, const float lhs[16], const float *rhs, size_t count);
+
+// matrices[i] = lhs * rhs[i], where matrices and rhs are arrays of count
+// tightly packed 16 float matrices
+void mat4MultiplyBatchScalar(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		mat4MultiplyScalar(matrices + i * 16, lhs, rhs + i * 16);
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void mat4MultiplyBatchSSE2(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		mat4MultiplySSE2(matrices + i * 16, lhs, rhs + i * 16);
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+void mat4MultiplyBatchAVX(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		mat4MultiplyAVX(matrices + i * 16, lhs, rhs + i * 16);
+}
+#endif
+
+#if defined(GLC_LINMATH_NEON)
+void mat4MultiplyBatchNEON(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		mat4MultiplyNEON(matrices + i * 16, lhs, rhs + i * 16);
+}
+#endif
+
+GLCMat4MultiplyBatchFunc mat4GetMultiplyBatchFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return mat4MultiplyBatchAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return mat4MultiplyBatchSSE2;
+#endif
+#if defined(GLC_LINMATH_NEON)
+	case GLC_SIMD_NEON:
+		return mat4MultiplyBatchNEON;
+#endif
+	default:
+		return mat4MultiplyBatchScalar;
+	}
+}
+
+void mat4MultiplyBatch(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	static const GLCMat4MultiplyBatchFunc multiply = mat4GetMultiplyBatchFunc(linmathGetSIMDLevel());
+	multiply(matrices, lhs, rhs, count);
+}
+
+// Structure-of-arrays matrix storage, elements[i][n] is element i of matrix n.
+// Each element array is 32 byte aligned and padded to a multiple of
+// GLC_MAT4_SOA_WIDTH, so kernels always process whole groups of matrices
+#define GLC_MAT4_SOA_WIDTH 8
+
+typedef struct GLCMat4SoA
+{
+	float *elements[16];
+	size_t count, capacity;
+	void *memory;
+} GLCMat4SoA;
+
+int mat4SoACreate(GLCMat4SoA *matrices, size_t count)
+{
+	const size_t capacity = (count + GLC_MAT4_SOA_WIDTH - 1) / GLC_MAT4_SOA_WIDTH * GLC_MAT4_SOA_WIDTH;
+
+	// Element arrays are staggered by a cache line, as power of two strides
+	// map all 16 streams onto the same cache sets
+	const size_t stride = capacity + 16;
+	const size_t size = 16 * stride * sizeof(float);
+
+	memset(matrices, 0, sizeof(GLCMat4SoA));
+
+	void *memory = malloc(size + 31);
+
+	if (!memory)
+		return 0;
+
+	// Padding is zeroed, so it never contains NaNs or denormals
+	float *elements = (float*) (((uintptr_t) memory + 31) & ~(uintptr_t) 31);
+	memset(elements, 0, size);
+
+	for (int i = 0; i < 16; ++i)
+		matrices->elements[i] = elements + i * stride;
+
+	matrices->count = count;
+	matrices->capacity = capacity;
+	matrices->memory = memory;
+
+	return 1;
+}
+
+void mat4SoADestroy(GLCMat4SoA *matrices)
+{
+	free(matrices->memory);
+	memset(matrices, 0, sizeof(GLCMat4SoA));
+}
+
+void mat4SoASet(GLCMat4SoA *matrices, size_t index, const float matrix[16])
+{
+	for (int i = 0; i < 16; ++i)
+		matrices->elements[i][index] = matrix[i];
+}
+
+void mat4SoAGet(const GLCMat4SoA *matrices, size_t index, float matrix[16])
+{
+	for (int i = 0; i < 16; ++i)
+		matrix[i] = matrices->elements[i][index];
+}
+
+typedef void (*GLCMat4SoAMultiplyFunc)(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end);
+
+// Kernels compute matrices[n] = lhs * rhs[n] for n in [begin, end), where
+// begin and end are multiples of GLC_MAT4_SOA_WIDTH
+void mat4SoAMultiplyScalar(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end)
+{
+	for (size_t n = begin; n < end; ++n)
+	{
+		float matrix[16];
+
+		for (int i = 0; i < 16; ++i)
+			matrix[i] = rhs->elements[i][n];
+
+		mat4MultiplyScalar(matrix, lhs, matrix);
+		mat4SoASet(matrices, n, matrix);
+	}
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void mat4SoAMultiplySSE2(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end)
+{
+	__m128 l[16];
+
+	for (int i = 0; i < 16; ++i)
+		l[i] = _mm_set1_ps(lhs[i]);
+
+	for (size_t n = begin; n < end; n += 4)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			const __m128 r0 = _mm_load_ps(rhs->elements[i * 4 + 0] + n);
+			const __m128 r1 = _mm_load_ps(rhs->elements[i * 4 + 1] + n);
+			const __m128 r2 = _mm_load_ps(rhs->elements[i * 4 + 2] + n);
+			const __m128 r3 = _mm_load_ps(rhs->elements[i * 4 + 3] + n);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				__m128 e = _mm_mul_ps(l[j + 0 * 4], r0);
+				e = _mm_add_ps(e, _mm_mul_ps(l[j + 1 * 4], r1));
+				e = _mm_add_ps(e, _mm_mul_ps(l[j + 2 * 4], r2));
+				e = _mm_add_ps(e, _mm_mul_ps(l[j + 3 * 4], r3));
+
+				_mm_store_ps(matrices->elements[i * 4 + j] + n, e);
+			}
+		}
+	}
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+void mat4SoAMultiplyAVX(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end)
+{
+	__m256 l[16];
+
+	for (int i = 0; i < 16; ++i)
+		l[i] = _mm256_set1_ps(lhs[i]);
+
+	for (size_t n = begin; n < end; n += 8)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			const __m256 r0 = _mm256_load_ps(rhs->elements[i * 4 + 0] + n);
+			const __m256 r1 = _mm256_load_ps(rhs->elements[i * 4 + 1] + n);
+			const __m256 r2 = _mm256_load_ps(rhs->elements[i * 4 + 2] + n);
+			const __m256 r3 = _mm256_load_ps(rhs->elements[i * 4 + 3] + n);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				__m256 e = _mm256_mul_ps(l[j + 0 * 4], r0);
+				e = _mm256_add_ps(e, _mm256_mul_ps(l[j + 1 * 4], r1));
+				e = _mm256_add_ps(e, _mm256_mul_ps(l[j + 2 * 4], r2));
+				e = _mm256_add_ps(e, _mm256_mul_ps(l[j + 3 * 4], r3));
+
+				_mm256_store_ps(matrices->elements[i * 4 + j] + n, e);
+			}
+		}
+	}
+}
+#endif
+
+#if defined(GLC_LINMATH_NEON)
+void mat4SoAMultiplyNEON(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end)
+{
+	for (size_t n = begin; n < end; n += 4)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			const float32x4_t r0 = vld1q_f32(rhs->elements[i * 4 + 0] + n);
+			const float32x4_t r1 = vld1q_f32(rhs->elements[i * 4 + 1] + n);
+			const float32x4_t r2 = vld1q_f32(rhs->elements[i * 4 + 2] + n);
+			const float32x4_t r3 = vld1q_f32(rhs->elements[i * 4 + 3] + n);
+
+			for (int j = 0; j < 4; ++j)
+			{
+				float32x4_t e = vmulq_n_f32(r0, lhs[j + 0 * 4]);
+				e = vaddq_f32(e, vmulq_n_f32(r1, lhs[j + 1 * 4]));
+				e = vaddq_f32(e, vmulq_n_f32(r2, lhs[j + 2 * 4]));
+				e = vaddq_f32(e, vmulq_n_f32(r3, lhs[j + 3 * 4]));
+
+				vst1q_f32(matrices->elements[i * 4 + j] + n, e);
+			}
+		}
+	}
+}
+#endif
+
+GLCMat4SoAMultiplyFunc mat4GetSoAMultiplyFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return mat4SoAMultiplyAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return mat4SoAMultiplySSE2;
+#endif
+#if defined(GLC_LINMATH_NEON)
+	case GLC_SIMD_NEON:
+		return mat4SoAMultiplyNEON;
+#endif
+	default:
+		return mat4SoAMultiplyScalar;
+	}
+}
+
+// Multiplies the matrices in [begin, end), begin must be a multiple of
+// GLC_MAT4_SOA_WIDTH, end is rounded up into the padding
+void mat4SoAMultiplyRange(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs, size_t begin, size_t end)
+{
+	static const GLCMat4SoAMultiplyFunc multiply = mat4GetSoAMultiplyFunc(linmathGetSIMDLevel());
+
+	end = (end + GLC_MAT4_SOA_WIDTH - 1) / GLC_MAT4_SOA_WIDTH * GLC_MAT4_SOA_WIDTH;
+
+	if (begin < end)
+		multiply(matrices, lhs, rhs, begin, end);
+}
+
+// matrices[n] = lhs * rhs[n] for all rhs->count matrices, matrices must have
+// at least the capacity of rhs and may be rhs itself
+void mat4SoAMultiplyBatch(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs)
+{
+	mat4SoAMultiplyRange(matrices, lhs, rhs, 0, rhs->count);
+	matrices->count = rhs->count;
 }
 
 void mat4Perspective(float matrix[16], float fov, float aspect, float zNear, float zFar)
@@ -63,6 +694,568 @@ void mat4Perspective(float matrix[16], float fov, float aspect, float zNear, flo
 	matrix[15] = 0.0f;
 }
 
+// matrix = perspective * rhs, only touching the 5 non-zero elements of the
+// perspective matrix, 20 flops instead of 112 for a full multiply. Meant for
+// building the view projection once per frame, per object that is then
+// mat4Multiply(mvp, viewProjection, model)
+void mat4PerspectiveMultiply(float matrix[16], float fov, float aspect, float zNear, float zFar, const float rhs[16])
+{
+	fov = GLC_RAD(fov);
+
+	const float range = tanf(fov * 0.5f) * zNear;
+
+	const float sx = (zNear * 2.0f) / (range * aspect + range * aspect);
+	const float sy = zNear / range;
+	const float sz = -(zFar + zNear) / (zFar - zNear);
+	const float tz = -(zFar * zNear * 2.0f) / (zFar - zNear);
+
+	// Read up front, such that matrix may be rhs and the stores cannot alias
+	float m[16];
+	memcpy(m, rhs, sizeof(m));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const float x = m[i * 4 + 0], y = m[i * 4 + 1];
+		const float z = m[i * 4 + 2], w = m[i * 4 + 3];
+
+		matrix[i * 4 + 0] = sx * x;
+		matrix[i * 4 + 1] = sy * y;
+		matrix[i * 4 + 2] = sz * z + tz * w;
+		matrix[i * 4 + 3] = -z;
+	}
+}
+
+typedef int (*GLCMat4InverseFunc)(float matrix[16], const float m[16]);
+
+// General inverse using cofactor expansion, returns 0 and leaves matrix
+// untouched if m is singular
+int mat4InverseScalar(float matrix[16], const float m[16])
+{
+	float inv[16];
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	const float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+
+	if (det == 0.0f)
+		return 0;
+
+	const float invDet = 1.0f / det;
+
+	for (int i = 0; i < 16; ++i)
+		matrix[i] = inv[i] * invDet;
+
+	return 1;
+}
+
+#if defined(GLC_LINMATH_SSE2)
+// Each __m128 holds a 2x2 block (x0, x1, x2, x3) of the 4x4 matrix, the
+// inverse is computed blockwise using 2x2 adjugates instead of 3x3 cofactors.
+// The method doesn't depend on the storage order, as inverse(transpose(m))
+// equals transpose(inverse(m))
+
+// lhs * rhs
+__m128 mat2MultiplySSE2(__m128 lhs, __m128 rhs)
+{
+	return _mm_add_ps(_mm_mul_ps(lhs, _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 3, 0))),
+	                  _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// adjugate(lhs) * rhs
+__m128 mat2AdjugateMultiplySSE2(__m128 lhs, __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(0, 0, 3, 3)), rhs),
+	                  _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// lhs * adjugate(rhs)
+__m128 mat2MultiplyAdjugateSSE2(__m128 lhs, __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(lhs, _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(0, 3, 0, 3))),
+	                  _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+int mat4InverseSSE2(float matrix[16], const float m[16])
+{
+	const __m128 m0 = _mm_loadu_ps(m + 0);
+	const __m128 m1 = _mm_loadu_ps(m + 4);
+	const __m128 m2 = _mm_loadu_ps(m + 8);
+	const __m128 m3 = _mm_loadu_ps(m + 12);
+
+	const __m128 a = _mm_movelh_ps(m0, m1);
+	const __m128 b = _mm_movehl_ps(m1, m0);
+	const __m128 c = _mm_movelh_ps(m2, m3);
+	const __m128 d = _mm_movehl_ps(m3, m2);
+
+	// Determinants of the blocks (|a|, |b|, |c|, |d|)
+	const __m128 detBlocks = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(m1, m3, _MM_SHUFFLE(3, 1, 3, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(m1, m3, _MM_SHUFFLE(2, 0, 2, 0))));
+
+	const __m128 detA = _mm_shuffle_ps(detBlocks, detBlocks, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 detB = _mm_shuffle_ps(detBlocks, detBlocks, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 detC = _mm_shuffle_ps(detBlocks, detBlocks, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 detD = _mm_shuffle_ps(detBlocks, detBlocks, _MM_SHUFFLE(3, 3, 3, 3));
+
+	const __m128 dc = mat2AdjugateMultiplySSE2(d, c);
+	const __m128 ab = mat2AdjugateMultiplySSE2(a, b);
+
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mat2MultiplySSE2(b, dc));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mat2MultiplySSE2(c, ab));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mat2MultiplyAdjugateSSE2(d, ab));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mat2MultiplyAdjugateSSE2(a, dc));
+
+	// |m| = |a||d| + |b||c| - trace(adjugate(a) * b * adjugate(d) * c)
+	__m128 trace = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+	trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+	trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+	if (_mm_cvtss_f32(det) == 0.0f)
+		return 0;
+
+	const __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+
+	x = _mm_mul_ps(x, invDet);
+	y = _mm_mul_ps(y, invDet);
+	z = _mm_mul_ps(z, invDet);
+	w = _mm_mul_ps(w, invDet);
+
+	// Applies the final adjugate of each block while storing
+	_mm_storeu_ps(matrix + 0, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(matrix + 4, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(matrix + 8, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(matrix + 12, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+
+	return 1;
+}
+#endif
+
+GLCMat4InverseFunc mat4GetInverseFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_AVX:
+	case GLC_SIMD_SSE2:
+		return mat4InverseSSE2;
+#endif
+	default:
+		return mat4InverseScalar;
+	}
+}
+
+// matrix may alias m
+int mat4Inverse(float matrix[16], const float m[16])
+{
+	static const GLCMat4InverseFunc inverse = mat4GetInverseFunc(linmathGetSIMDLevel());
+	return inverse(matrix, m);
+}
+
+// Inverse of an affine matrix (last row is 0, 0, 0, 1), inverting only the
+// upper 3x3 block and the translation. Returns 0 if m is singular
+int mat4InverseAffine(float matrix[16], const float m[16])
+{
+	float inv[9];
+
+	inv[0] = m[5] * m[10] - m[6] * m[9];
+	inv[1] = m[2] * m[9] - m[1] * m[10];
+	inv[2] = m[1] * m[6] - m[2] * m[5];
+
+	inv[3] = m[6] * m[8] - m[4] * m[10];
+	inv[4] = m[0] * m[10] - m[2] * m[8];
+	inv[5] = m[2] * m[4] - m[0] * m[6];
+
+	inv[6] = m[4] * m[9] - m[5] * m[8];
+	inv[7] = m[1] * m[8] - m[0] * m[9];
+	inv[8] = m[0] * m[5] - m[1] * m[4];
+
+	const float det = m[0] * inv[0] + m[4] * inv[1] + m[8] * inv[2];
+
+	if (det == 0.0f)
+		return 0;
+
+	const float invDet = 1.0f / det;
+
+	for (int i = 0; i < 9; ++i)
+		inv[i] *= invDet;
+
+	const float tx = m[12], ty = m[13], tz = m[14];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		matrix[i * 4 + 0] = inv[i * 3 + 0];
+		matrix[i * 4 + 1] = inv[i * 3 + 1];
+		matrix[i * 4 + 2] = inv[i * 3 + 2];
+		matrix[i * 4 + 3] = 0.0f;
+	}
+
+	matrix[12] = -(inv[0] * tx + inv[3] * ty + inv[6] * tz);
+	matrix[13] = -(inv[1] * tx + inv[4] * ty + inv[7] * tz);
+	matrix[14] = -(inv[2] * tx + inv[5] * ty + inv[8] * tz);
+	matrix[15] = 1.0f;
+
+	return 1;
+}
+
+// Inverse of a rigid body transform (rotation and translation only), where
+// the inverse rotation is the transpose. View matrices are usually rigid
+void mat4InverseRigid(float matrix[16], const float m[16])
+{
+	const float tx = m[12], ty = m[13], tz = m[14];
+
+	float rotation[9];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		rotation[i * 3 + 0] = m[0 * 4 + i];
+		rotation[i * 3 + 1] = m[1 * 4 + i];
+		rotation[i * 3 + 2] = m[2 * 4 + i];
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		matrix[i * 4 + 0] = rotation[i * 3 + 0];
+		matrix[i * 4 + 1] = rotation[i * 3 + 1];
+		matrix[i * 4 + 2] = rotation[i * 3 + 2];
+		matrix[i * 4 + 3] = 0.0f;
+	}
+
+	matrix[12] = -(rotation[0] * tx + rotation[3] * ty + rotation[6] * tz);
+	matrix[13] = -(rotation[1] * tx + rotation[4] * ty + rotation[7] * tz);
+	matrix[14] = -(rotation[2] * tx + rotation[5] * ty + rotation[8] * tz);
+	matrix[15] = 1.0f;
+}
+
+// Column-major 3x3 normal matrix, the inverse transpose of the upper 3x3
+// block of model, for transforming normals of non-uniformly scaled models.
+// Returns 0 if model is singular
+int mat3NormalMatrix(float normal[9], const float model[16])
+{
+	const float *m = model;
+
+	// The inverse transpose is the cofactor matrix divided by the determinant
+	float cofactors[9];
+
+	cofactors[0] = m[5] * m[10] - m[6] * m[9];
+	cofactors[1] = m[6] * m[8] - m[4] * m[10];
+	cofactors[2] = m[4] * m[9] - m[5] * m[8];
+
+	cofactors[3] = m[2] * m[9] - m[1] * m[10];
+	cofactors[4] = m[0] * m[10] - m[2] * m[8];
+	cofactors[5] = m[1] * m[8] - m[0] * m[9];
+
+	cofactors[6] = m[1] * m[6] - m[2] * m[5];
+	cofactors[7] = m[2] * m[4] - m[0] * m[6];
+	cofactors[8] = m[0] * m[5] - m[1] * m[4];
+
+	const float det = m[0] * cofactors[0] + m[1] * cofactors[1] + m[2] * cofactors[2];
+
+	if (det == 0.0f)
+		return 0;
+
+	const float invDet = 1.0f / det;
+
+	for (int i = 0; i < 9; ++i)
+		normal[i] = cofactors[i] * invDet;
+
+	return 1;
+}
+
+// Transforms of arrays of 3 component points or directions by an affine
+// matrix, where points are translated and directions aren't (w = 1 or 0).
+// The AoS variants read and write x, y, z at the start of each element,
+// with strides given in bytes, e.g. sizeof(LoadOBJTriangleVertex). The SoA
+// variants take separate x, y and z arrays. Output may alias input
+
+typedef void (*GLCMat4TransformAoSFunc)(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w);
+typedef void (*GLCMat4TransformSoAFunc)(float *const *out, const float m[16], const float *const *in, size_t count, float w);
+
+void mat4TransformAoSScalar(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w)
+{
+	const char *src = (const char*) in;
+	char *dst = (char*) out;
+
+	for (size_t i = 0; i < count; ++i, src += inStride, dst += outStride)
+	{
+		const float *v = (const float*) src;
+		const float x = v[0], y = v[1], z = v[2];
+
+		float *r = (float*) dst;
+		r[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+		r[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+		r[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+	}
+}
+
+void mat4TransformSoAScalar(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float x = in[0][i], y = in[1][i], z = in[2][i];
+
+		out[0][i] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+		out[1][i] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+		out[2][i] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+	}
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void mat4TransformAoSSSE2(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w)
+{
+	const __m128 c0 = _mm_loadu_ps(m + 0);
+	const __m128 c1 = _mm_loadu_ps(m + 4);
+	const __m128 c2 = _mm_loadu_ps(m + 8);
+	const __m128 c3 = _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(w));
+
+	const char *src = (const char*) in;
+	char *dst = (char*) out;
+
+	for (size_t i = 0; i < count; ++i, src += inStride, dst += outStride)
+	{
+		const float *v = (const float*) src;
+
+		__m128 r = _mm_mul_ps(c0, _mm_set1_ps(v[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+		r = _mm_add_ps(r, c3);
+
+		// Only x, y, z are written, as the element may be tightly packed
+		_mm_storel_pi((__m64*) dst, r);
+		_mm_store_ss((float*) dst + 2, _mm_movehl_ps(r, r));
+	}
+}
+
+void mat4TransformSoASSE2(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	__m128 e[12];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		e[i * 4 + 0] = _mm_set1_ps(m[i]);
+		e[i * 4 + 1] = _mm_set1_ps(m[4 + i]);
+		e[i * 4 + 2] = _mm_set1_ps(m[8 + i]);
+		e[i * 4 + 3] = _mm_set1_ps(m[12 + i] * w);
+	}
+
+	size_t n = 0;
+
+	for (; (n + 4) <= count; n += 4)
+	{
+		const __m128 x = _mm_loadu_ps(in[0] + n);
+		const __m128 y = _mm_loadu_ps(in[1] + n);
+		const __m128 z = _mm_loadu_ps(in[2] + n);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			__m128 r = _mm_mul_ps(e[i * 4 + 0], x);
+			r = _mm_add_ps(r, _mm_mul_ps(e[i * 4 + 1], y));
+			r = _mm_add_ps(r, _mm_mul_ps(e[i * 4 + 2], z));
+			r = _mm_add_ps(r, e[i * 4 + 3]);
+
+			_mm_storeu_ps(out[i] + n, r);
+		}
+	}
+
+	const float *const inTail[3] = { in[0] + n, in[1] + n, in[2] + n };
+	float *const outTail[3] = { out[0] + n, out[1] + n, out[2] + n };
+
+	mat4TransformSoAScalar(outTail, m, inTail, count - n, w);
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+void mat4TransformSoAAVX(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	__m256 e[12];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		e[i * 4 + 0] = _mm256_set1_ps(m[i]);
+		e[i * 4 + 1] = _mm256_set1_ps(m[4 + i]);
+		e[i * 4 + 2] = _mm256_set1_ps(m[8 + i]);
+		e[i * 4 + 3] = _mm256_set1_ps(m[12 + i] * w);
+	}
+
+	size_t n = 0;
+
+	for (; (n + 8) <= count; n += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(in[0] + n);
+		const __m256 y = _mm256_loadu_ps(in[1] + n);
+		const __m256 z = _mm256_loadu_ps(in[2] + n);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			__m256 r = _mm256_mul_ps(e[i * 4 + 0], x);
+			r = _mm256_add_ps(r, _mm256_mul_ps(e[i * 4 + 1], y));
+			r = _mm256_add_ps(r, _mm256_mul_ps(e[i * 4 + 2], z));
+			r = _mm256_add_ps(r, e[i * 4 + 3]);
+
+			_mm256_storeu_ps(out[i] + n, r);
+		}
+	}
+
+	// The scalar tail isn't compiled for AVX, avoid the SSE transition penalty
+	_mm256_zeroupper();
+
+	const float *const inTail[3] = { in[0] + n, in[1] + n, in[2] + n };
+	float *const outTail[3] = { out[0] + n, out[1] + n, out[2] + n };
+
+	mat4TransformSoAScalar(outTail, m, inTail, count - n, w);
+}
+#endif
+
+#if defined(GLC_LINMATH_NEON)
+void mat4TransformAoSNEON(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w)
+{
+	const float32x4_t c0 = vld1q_f32(m + 0);
+	const float32x4_t c1 = vld1q_f32(m + 4);
+	const float32x4_t c2 = vld1q_f32(m + 8);
+	const float32x4_t c3 = vmulq_n_f32(vld1q_f32(m + 12), w);
+
+	const char *src = (const char*) in;
+	char *dst = (char*) out;
+
+	for (size_t i = 0; i < count; ++i, src += inStride, dst += outStride)
+	{
+		const float *v = (const float*) src;
+
+		float32x4_t r = vmulq_n_f32(c0, v[0]);
+		r = vaddq_f32(r, vmulq_n_f32(c1, v[1]));
+		r = vaddq_f32(r, vmulq_n_f32(c2, v[2]));
+		r = vaddq_f32(r, c3);
+
+		vst1_f32((float*) dst, vget_low_f32(r));
+		vst1q_lane_f32((float*) dst + 2, r, 2);
+	}
+}
+
+void mat4TransformSoANEON(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	size_t n = 0;
+
+	for (; (n + 4) <= count; n += 4)
+	{
+		const float32x4_t x = vld1q_f32(in[0] + n);
+		const float32x4_t y = vld1q_f32(in[1] + n);
+		const float32x4_t z = vld1q_f32(in[2] + n);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			float32x4_t r = vmulq_n_f32(x, m[i]);
+			r = vaddq_f32(r, vmulq_n_f32(y, m[4 + i]));
+			r = vaddq_f32(r, vmulq_n_f32(z, m[8 + i]));
+			r = vaddq_f32(r, vdupq_n_f32(m[12 + i] * w));
+
+			vst1q_f32(out[i] + n, r);
+		}
+	}
+
+	const float *const inTail[3] = { in[0] + n, in[1] + n, in[2] + n };
+	float *const outTail[3] = { out[0] + n, out[1] + n, out[2] + n };
+
+	mat4TransformSoAScalar(outTail, m, inTail, count - n, w);
+}
+#endif
+
+GLCMat4TransformAoSFunc mat4GetTransformAoSFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_AVX:
+	case GLC_SIMD_SSE2:
+		return mat4TransformAoSSSE2;
+#endif
+#if defined(GLC_LINMATH_NEON)
+	case GLC_SIMD_NEON:
+		return mat4TransformAoSNEON;
+#endif
+	default:
+		return mat4TransformAoSScalar;
+	}
+}
+
+GLCMat4TransformSoAFunc mat4GetTransformSoAFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return mat4TransformSoAAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return mat4TransformSoASSE2;
+#endif
+#if defined(GLC_LINMATH_NEON)
+	case GLC_SIMD_NEON:
+		return mat4TransformSoANEON;
+#endif
+	default:
+		return mat4TransformSoAScalar;
+	}
+}
+
+void mat4TransformAoS(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w)
+{
+	static const GLCMat4TransformAoSFunc transform = mat4GetTransformAoSFunc(linmathGetSIMDLevel());
+	transform(out, outStride, m, in, inStride, count, w);
+}
+
+void mat4TransformSoA(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	static const GLCMat4TransformSoAFunc transform = mat4GetTransformSoAFunc(linmathGetSIMDLevel());
+	transform(out, m, in, count, w);
+}
+
+void mat4TransformPoints(float *out, size_t outStride, const float m[16], const float *points, size_t stride, size_t count)
+{
+	mat4TransformAoS(out, outStride, m, points, stride, count, 1.0f);
+}
+
+void mat4TransformDirections(float *out, size_t outStride, const float m[16], const float *directions, size_t stride, size_t count)
+{
+	mat4TransformAoS(out, outStride, m, directions, stride, count, 0.0f);
+}
+
+void mat4TransformPointsSoA(float *outX, float *outY, float *outZ, const float m[16], const float *x, const float *y, const float *z, size_t count)
+{
+	float *const out[3] = { outX, outY, outZ };
+	const float *const in[3] = { x, y, z };
+
+	mat4TransformSoA(out, m, in, count, 1.0f);
+}
+
+void mat4TransformDirectionsSoA(float *outX, float *outY, float *outZ, const float m[16], const float *x, const float *y, const float *z, size_t count)
+{
+	float *const out[3] = { outX, outY, outZ };
+	const float *const in[3] = { x, y, z };
+
+	mat4TransformSoA(out, m, in, count, 0.0f);
+}
+
 void mat4Translation(float matrix[16], float x, float y, float z)
 {
 	const float translation[16] = {
@@ -87,9 +1280,10 @@ void mat4Scaling(float matrix[16], float sx, float sy, float sz)
 	memcpy(matrix, translation, sizeof(translation));
 }
 
-void mat4Rotation(float matrix[16], float angle, float x, float y, float z)
+// Rotation from a precomputed sine and cosine of the angle, e.g. from
+// linmathSinCosBatch when building many rotations at once
+void mat4RotationSinCos(float matrix[16], float s, float c, float x, float y, float z)
 {
-	const float s = sinf(angle), c = cosf(angle);
 	const float oc = 1.0f - c;
 
 	matrix[0] = x * x * oc + c;
@@ -113,34 +1307,54 @@ void mat4Rotation(float matrix[16], float angle, float x, float y, float z)
 	matrix[15] = 1.0f;
 }
 
-void mat4Translate(float matrix[16], float x, float y, float z)
+void mat4Rotation(float matrix[16], float angle, float x, float y, float z)
 {
-	float transform[16], result[16];
+	const float s = sinf(angle), c = cosf(angle);
 
-	mat4Translation(transform, x, y, z);
-	mat4Multiply(result, matrix, transform);
+	mat4RotationSinCos(matrix, s, c, x, y, z);
+}
 
-	memcpy(matrix, result, sizeof(result));
+// The transforms below post-multiply in place, only updating the columns
+// the transform affects instead of building it and doing a full multiply
+
+void mat4Translate(float matrix[16], float x, float y, float z)
+{
+	for (int j = 0; j < 4; ++j)
+		matrix[12 + j] = matrix[j] * x + matrix[4 + j] * y + matrix[8 + j] * z + matrix[12 + j];
 }
 
 void mat4Scale(float matrix[16], float sx, float sy, float sz)
 {
-	float transform[16], result[16];
-
-	mat4Scaling(transform, sx, sy, sz);
-	mat4Multiply(result, matrix, transform);
-
-	memcpy(matrix, result, sizeof(result));
+	for (int j = 0; j < 4; ++j)
+	{
+		matrix[0 + j] *= sx;
+		matrix[4 + j] *= sy;
+		matrix[8 + j] *= sz;
+	}
 }
 
 void mat4Rotate(float matrix[16], float angle, float x, float y, float z)
 {
-	float transform[16], result[16];
+	float rotation[16];
+	mat4Rotation(rotation, angle, x, y, z);
 
-	mat4Rotation(transform, angle, x, y, z);
-	mat4Multiply(result, matrix, transform);
+	// The fourth column is unaffected, and only the upper 3x3 block of
+	// rotation contributes to the other three
+	float c0[4], c1[4], c2[4];
 
-	memcpy(matrix, result, sizeof(result));
+	memcpy(c0, matrix + 0, sizeof(c0));
+	memcpy(c1, matrix + 4, sizeof(c1));
+	memcpy(c2, matrix + 8, sizeof(c2));
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const float r0 = rotation[i * 4 + 0];
+		const float r1 = rotation[i * 4 + 1];
+		const float r2 = rotation[i * 4 + 2];
+
+		for (int j = 0; j < 4; ++j)
+			matrix[i * 4 + j] = c0[j] * r0 + c1[j] * r1 + c2[j] * r2;
+	}
 }
 
 #endif
\ No newline at end of file
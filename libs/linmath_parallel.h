@@ -0,0 +1,126 @@
+#ifndef GLC_LINMATH_PARALLEL_H
+#define GLC_LINMATH_PARALLEL_H
+
+#include <thread>
+#include <vector>
+
+#include "linmath.h"
+
+// Batches smaller than this are not worth the cost of starting threads
+#define GLC_LINMATH_PARALLEL_MIN_COUNT 4096
+
+unsigned int linmathDetectThreadCount()
+{
+	const unsigned int threadCount = std::thread::hardware_concurrency();
+	return threadCount ? threadCount : 1;
+}
+
+unsigned int linmathGetThreadCount()
+{
+	static const unsigned int threadCount = linmathDetectThreadCount();
+	return threadCount;
+}
+
+// Splits [0, count) into contiguous ranges of at least minCount items, each
+// a multiple of alignment, and calls func(begin, end) for each range. The
+// calling thread processes the first range itself
+template<typename Func>
+void linmathParallelFor(size_t count, size_t minCount, size_t alignment, Func func)
+{
+	size_t threadCount = linmathGetThreadCount();
+
+	if (minCount < 1)
+		minCount = 1;
+
+	if ((count / minCount) < threadCount)
+		threadCount = count / minCount;
+
+	if (threadCount <= 1)
+	{
+		func((size_t) 0, count);
+		return;
+	}
+
+	size_t rangeSize = (count + threadCount - 1) / threadCount;
+	rangeSize = (rangeSize + alignment - 1) / alignment * alignment;
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+
+	for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+	{
+		const size_t end = ((begin + rangeSize) < count) ? (begin + rangeSize) : count;
+		threads.push_back(std::thread(func, begin, end));
+	}
+
+	func((size_t) 0, (rangeSize < count) ? rangeSize : count);
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+void mat4MultiplyBatchParallel(float *matrices, const float lhs[16], const float *rhs, size_t count)
+{
+	linmathParallelFor(count, GLC_LINMATH_PARALLEL_MIN_COUNT, 1, [=](size_t begin, size_t end)
+	{
+		mat4MultiplyBatch(matrices + begin * 16, lhs, rhs + begin * 16, end - begin);
+	});
+}
+
+void mat4SoAMultiplyBatchParallel(GLCMat4SoA *matrices, const float lhs[16], const GLCMat4SoA *rhs)
+{
+	linmathParallelFor(rhs->count, GLC_LINMATH_PARALLEL_MIN_COUNT, GLC_MAT4_SOA_WIDTH, [=](size_t begin, size_t end)
+	{
+		mat4SoAMultiplyRange(matrices, lhs, rhs, begin, end);
+	});
+
+	matrices->count = rhs->count;
+}
+
+void mat4TransformAoSParallel(float *out, size_t outStride, const float m[16], const float *in, size_t inStride, size_t count, float w)
+{
+	linmathParallelFor(count, GLC_LINMATH_PARALLEL_MIN_COUNT, 1, [=](size_t begin, size_t end)
+	{
+		mat4TransformAoS((float*) ((char*) out + begin * outStride), outStride, m,
+		                 (const float*) ((const char*) in + begin * inStride), inStride, end - begin, w);
+	});
+}
+
+void mat4TransformSoAParallel(float *const *out, const float m[16], const float *const *in, size_t count, float w)
+{
+	linmathParallelFor(count, GLC_LINMATH_PARALLEL_MIN_COUNT, GLC_MAT4_SOA_WIDTH, [=](size_t begin, size_t end)
+	{
+		float *const outRange[3] = { out[0] + begin, out[1] + begin, out[2] + begin };
+		const float *const inRange[3] = { in[0] + begin, in[1] + begin, in[2] + begin };
+
+		mat4TransformSoA(outRange, m, inRange, end - begin, w);
+	});
+}
+
+void mat4TransformPointsParallel(float *out, size_t outStride, const float m[16], const float *points, size_t stride, size_t count)
+{
+	mat4TransformAoSParallel(out, outStride, m, points, stride, count, 1.0f);
+}
+
+void mat4TransformDirectionsParallel(float *out, size_t outStride, const float m[16], const float *directions, size_t stride, size_t count)
+{
+	mat4TransformAoSParallel(out, outStride, m, directions, stride, count, 0.0f);
+}
+
+void mat4TransformPointsSoAParallel(float *outX, float *outY, float *outZ, const float m[16], const float *x, const float *y, const float *z, size_t count)
+{
+	float *const out[3] = { outX, outY, outZ };
+	const float *const in[3] = { x, y, z };
+
+	mat4TransformSoAParallel(out, m, in, count, 1.0f);
+}
+
+void mat4TransformDirectionsSoAParallel(float *outX, float *outY, float *outZ, const float m[16], const float *x, const float *y, const float *z, size_t count)
+{
+	float *const out[3] = { outX, outY, outZ };
+	const float *const in[3] = { x, y, z };
+
+	mat4TransformSoAParallel(out, m, in, count, 0.0f);
+}
+
+#endif
@@ -0,0 +1,855 @@
+#ifndef GLC_QUATERNION_H
+#define GLC_QUATERNION_H
+
+#include "linmath.h"
+
+// Quaternions are stored as (x, y, z, w), and rotate with the same
+// handedness as mat4Rotation, such that quatToMat4 of quatRotation equals
+// mat4Rotation for the same angle and axis. Composing with quatMultiply
+// matches mat4Multiply of the corresponding matrices
+
+void quatIdentity(float q[4])
+{
+	q[0] = 0.0f;
+	q[1] = 0.0f;
+	q[2] = 0.0f;
+	q[3] = 1.0f;
+}
+
+// (x, y, z) must be normalized
+void quatRotation(float q[4], float angle, float x, float y, float z)
+{
+	const float s = sinf(angle * -0.5f), c = cosf(angle * -0.5f);
+
+	q[0] = x * s;
+	q[1] = y * s;
+	q[2] = z * s;
+	q[3] = c;
+}
+
+// q may alias lhs and/or rhs
+void quatMultiply(float q[4], const float lhs[4], const float rhs[4])
+{
+	const float x = lhs[3] * rhs[0] + lhs[0] * rhs[3] + lhs[1] * rhs[2] - lhs[2] * rhs[1];
+	const float y = lhs[3] * rhs[1] - lhs[0] * rhs[2] + lhs[1] * rhs[3] + lhs[2] * rhs[0];
+	const float z = lhs[3] * rhs[2] + lhs[0] * rhs[1] - lhs[1] * rhs[0] + lhs[2] * rhs[3];
+	const float w = lhs[3] * rhs[3] - lhs[0] * rhs[0] - lhs[1] * rhs[1] - lhs[2] * rhs[2];
+
+	q[0] = x;
+	q[1] = y;
+	q[2] = z;
+	q[3] = w;
+}
+
+void quatConjugate(float q[4], const float src[4])
+{
+	q[0] = -src[0];
+	q[1] = -src[1];
+	q[2] = -src[2];
+	q[3] = src[3];
+}
+
+float quatDot(const float lhs[4], const float rhs[4])
+{
+	return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2] + lhs[3] * rhs[3];
+}
+
+void quatNormalize(float q[4])
+{
+	const float length = sqrtf(quatDot(q, q));
+
+	if (length == 0.0f)
+	{
+		quatIdentity(q);
+		return;
+	}
+
+	const float invLength = 1.0f / length;
+
+	for (int i = 0; i < 4; ++i)
+		q[i] *= invLength;
+}
+
+// q must be normalized
+void quatToMat4(float matrix[16], const float q[4])
+{
+	const float x = q[0], y = q[1], z = q[2], w = q[3];
+
+	const float xx = x * x, yy = y * y, zz = z * z;
+	const float xy = x * y, xz = x * z, yz = y * z;
+	const float wx = w * x, wy = w * y, wz = w * z;
+
+	matrix[0] = 1.0f - 2.0f * (yy + zz);
+	matrix[1] = 2.0f * (xy + wz);
+	matrix[2] = 2.0f * (xz - wy);
+	matrix[3] = 0.0f;
+
+	matrix[4] = 2.0f * (xy - wz);
+	matrix[5] = 1.0f - 2.0f * (xx + zz);
+	matrix[6] = 2.0f * (yz + wx);
+	matrix[7] = 0.0f;
+
+	matrix[8] = 2.0f * (xz + wy);
+	matrix[9] = 2.0f * (yz - wx);
+	matrix[10] = 1.0f - 2.0f * (xx + yy);
+	matrix[11] = 0.0f;
+
+	matrix[12] = 0.0f;
+	matrix[13] = 0.0f;
+	matrix[14] = 0.0f;
+	matrix[15] = 1.0f;
+}
+
+// Extracts the rotation of the upper 3x3 block, which must be orthonormal
+void quatFromMat4(float q[4], const float m[16])
+{
+	const float trace = m[0] + m[5] + m[10];
+
+	if (trace > 0.0f)
+	{
+		const float s = sqrtf(trace + 1.0f) * 2.0f;
+
+		q[0] = (m[6] - m[9]) / s;
+		q[1] = (m[8] - m[2]) / s;
+		q[2] = (m[1] - m[4]) / s;
+		q[3] = 0.25f * s;
+	}
+	else if ((m[0] > m[5]) && (m[0] > m[10]))
+	{
+		const float s = sqrtf(1.0f + m[0] - m[5] - m[10]) * 2.0f;
+
+		q[0] = 0.25f * s;
+		q[1] = (m[4] + m[1]) / s;
+		q[2] = (m[8] + m[2]) / s;
+		q[3] = (m[6] - m[9]) / s;
+	}
+	else if (m[5] > m[10])
+	{
+		const float s = sqrtf(1.0f + m[5] - m[0] - m[10]) * 2.0f;
+
+		q[0] = (m[4] + m[1]) / s;
+		q[1] = 0.25f * s;
+		q[2] = (m[9] + m[6]) / s;
+		q[3] = (m[8] - m[2]) / s;
+	}
+	else
+	{
+		const float s = sqrtf(1.0f + m[10] - m[0] - m[5]) * 2.0f;
+
+		q[0] = (m[8] + m[2]) / s;
+		q[1] = (m[9] + m[6]) / s;
+		q[2] = 0.25f * s;
+		q[3] = (m[1] - m[4]) / s;
+	}
+
+	quatNormalize(q);
+}
+
+// Normalized linear interpolation along the shortest path
+void quatNlerp(float q[4], const float a[4], const float b[4], float t)
+{
+	const float sign = (quatDot(a, b) < 0.0f) ? -1.0f : 1.0f;
+
+	for (int i = 0; i < 4; ++i)
+		q[i] = a[i] + (b[i] * sign - a[i]) * t;
+
+	quatNormalize(q);
+}
+
+// Spherical linear interpolation along the shortest path
+void quatSlerp(float q[4], const float a[4], const float b[4], float t)
+{
+	float d = quatDot(a, b);
+	float sign = 1.0f;
+
+	if (d < 0.0f)
+	{
+		d = -d;
+		sign = -1.0f;
+	}
+
+	// Nearly parallel, where sin(theta) approaches 0 and nlerp is exact enough
+	if (d > 0.9995f)
+	{
+		quatNlerp(q, a, b, t);
+		return;
+	}
+
+	const float theta = acosf(d);
+	const float invSinTheta = 1.0f / sinf(theta);
+
+	const float wa = sinf((1.0f - t) * theta) * invSinTheta;
+	const float wb = sinf(t * theta) * invSinTheta * sign;
+
+	for (int i = 0; i < 4; ++i)
+		q[i] = a[i] * wa + b[i] * wb;
+}
+
+// Corrects t such that nlerp approximates slerp, without any trigonometric
+// functions. Max angular error is below 1e-3 radians, see linmath_bench
+float quatSlerpCorrection(float t, float d)
+{
+	const float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	const float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+
+	const float k = a * (t - 0.5f) * (t - 0.5f) + b;
+
+	return t + t * (t - 0.5f) * (t - 1.0f) * k;
+}
+
+// Dual quaternions are stored as (real, dual), each (x, y, z, w), where the
+// real part is the rotation and the dual part encodes the translation
+
+void dualquatIdentity(float dq[8])
+{
+	quatIdentity(dq);
+
+	dq[4] = 0.0f;
+	dq[5] = 0.0f;
+	dq[6] = 0.0f;
+	dq[7] = 0.0f;
+}
+
+// Rotates by q and then translates by (x, y, z), q must be normalized
+void dualquatFromQuatTranslation(float dq[8], const float q[4], float x, float y, float z)
+{
+	const float t[4] = { x * 0.5f, y * 0.5f, z * 0.5f, 0.0f };
+
+	memcpy(dq, q, 4 * sizeof(float));
+	quatMultiply(dq + 4, t, q);
+}
+
+// dq may alias lhs and/or rhs
+void dualquatMultiply(float dq[8], const float lhs[8], const float rhs[8])
+{
+	float real[4], dual[4], temp[4];
+
+	quatMultiply(real, lhs, rhs);
+
+	quatMultiply(dual, lhs, rhs + 4);
+	quatMultiply(temp, lhs + 4, rhs);
+
+	for (int i = 0; i < 4; ++i)
+		dual[i] += temp[i];
+
+	memcpy(dq, real, sizeof(real));
+	memcpy(dq + 4, dual, sizeof(dual));
+}
+
+void dualquatNormalize(float dq[8])
+{
+	const float length = sqrtf(quatDot(dq, dq));
+
+	if (length == 0.0f)
+	{
+		dualquatIdentity(dq);
+		return;
+	}
+
+	const float invLength = 1.0f / length;
+
+	for (int i = 0; i < 8; ++i)
+		dq[i] *= invLength;
+
+	// Keep the dual part orthogonal to the real part
+	const float d = quatDot(dq, dq + 4);
+
+	for (int i = 0; i < 4; ++i)
+		dq[4 + i] -= dq[i] * d;
+}
+
+// dq must be normalized
+void dualquatToMat4(float matrix[16], const float dq[8])
+{
+	quatToMat4(matrix, dq);
+
+	// translation = 2 * dual * conjugate(real)
+	float real[4], t[4];
+	quatConjugate(real, dq);
+	quatMultiply(t, dq + 4, real);
+
+	matrix[12] = t[0] * 2.0f;
+	matrix[13] = t[1] * 2.0f;
+	matrix[14] = t[2] * 2.0f;
+}
+
+// Dual quaternion linear blending of two transforms along the shortest path
+void dualquatNlerp(float dq[8], const float a[8], const float b[8], float t)
+{
+	const float sign = (quatDot(a, b) < 0.0f) ? -1.0f : 1.0f;
+
+	for (int i = 0; i < 8; ++i)
+		dq[i] = a[i] + (b[i] * sign - a[i]) * t;
+
+	dualquatNormalize(dq);
+}
+
+// Structure-of-arrays quaternion storage, components[i][n] is component i
+// of quaternion n, aligned and padded like GLCMat4SoA
+typedef struct GLCQuatSoA
+{
+	float *components[4];
+	size_t count, capacity;
+	void *memory;
+} GLCQuatSoA;
+
+int quatSoACreate(GLCQuatSoA *quats, size_t count)
+{
+	const size_t capacity = (count + GLC_MAT4_SOA_WIDTH - 1) / GLC_MAT4_SOA_WIDTH * GLC_MAT4_SOA_WIDTH;
+
+	// Staggered by a cache line, see mat4SoACreate
+	const size_t stride = capacity + 16;
+	const size_t size = 4 * stride * sizeof(float);
+
+	memset(quats, 0, sizeof(GLCQuatSoA));
+
+	void *memory = malloc(size + 31);
+
+	if (!memory)
+		return 0;
+
+	float *components = (float*) (((uintptr_t) memory + 31) & ~(uintptr_t) 31);
+	memset(components, 0, size);
+
+	for (int i = 0; i < 4; ++i)
+		quats->components[i] = components + i * stride;
+
+	quats->count = count;
+	quats->capacity = capacity;
+	quats->memory = memory;
+
+	return 1;
+}
+
+void quatSoADestroy(GLCQuatSoA *quats)
+{
+	free(quats->memory);
+	memset(quats, 0, sizeof(GLCQuatSoA));
+}
+
+void quatSoASet(GLCQuatSoA *quats, size_t index, const float q[4])
+{
+	for (int i = 0; i < 4; ++i)
+		quats->components[i][index] = q[i];
+}
+
+void quatSoAGet(const GLCQuatSoA *quats, size_t index, float q[4])
+{
+	for (int i = 0; i < 4; ++i)
+		q[i] = quats->components[i][index];
+}
+
+typedef void (*GLCQuatSoAInterpolateFunc)(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t, size_t begin, size_t end, int slerp);
+
+// Kernels interpolate quats[n] between a[n] and b[n] by t[n] for n in
+// [begin, end). The SIMD kernels need begin and end to be multiples of
+// their width, the scalar kernel takes any range. When slerp is non-zero t
+// is corrected with quatSlerpCorrection
+void quatSoAInterpolateScalar(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t, size_t begin, size_t end, int slerp)
+{
+	for (size_t n = begin; n < end; ++n)
+	{
+		float qa[4], qb[4], q[4];
+
+		quatSoAGet(a, n, qa);
+		quatSoAGet(b, n, qb);
+
+		const float d = quatDot(qa, qb);
+		const float s = slerp ? quatSlerpCorrection(t[n], fabsf(d)) : t[n];
+		const float sign = (d < 0.0f) ? -1.0f : 1.0f;
+
+		for (int i = 0; i < 4; ++i)
+			q[i] = qa[i] + (qb[i] * sign - qa[i]) * s;
+
+		// Zero length (padding) results in zero like the SIMD kernels, where
+		// quatNormalize would give the identity
+		const float length = sqrtf(quatDot(q, q));
+		const float invLength = (length > 0.0f) ? (1.0f / length) : 0.0f;
+
+		for (int i = 0; i < 4; ++i)
+			q[i] *= invLength;
+
+		quatSoASet(quats, n, q);
+	}
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void quatSoAInterpolateSSE2(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t, size_t begin, size_t end, int slerp)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t n = begin; n < end; n += 4)
+	{
+		__m128 qa[4], qb[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			qa[i] = _mm_load_ps(a->components[i] + n);
+			qb[i] = _mm_load_ps(b->components[i] + n);
+		}
+
+		__m128 d = _mm_mul_ps(qa[0], qb[0]);
+		d = _mm_add_ps(d, _mm_mul_ps(qa[1], qb[1]));
+		d = _mm_add_ps(d, _mm_mul_ps(qa[2], qb[2]));
+		d = _mm_add_ps(d, _mm_mul_ps(qa[3], qb[3]));
+
+		// Flip b onto the same hemisphere as a, by xoring in the sign of d
+		const __m128 sign = _mm_and_ps(d, signMask);
+		d = _mm_andnot_ps(signMask, d);
+
+		__m128 s = _mm_loadu_ps(t + n);
+
+		if (slerp)
+		{
+			__m128 ca = _mm_mul_ps(d, _mm_set1_ps(-1.43519f));
+			ca = _mm_mul_ps(d, _mm_add_ps(ca, _mm_set1_ps(3.55645f)));
+			ca = _mm_mul_ps(d, _mm_add_ps(ca, _mm_set1_ps(-3.2452f)));
+			ca = _mm_add_ps(ca, _mm_set1_ps(1.0904f));
+
+			__m128 cb = _mm_mul_ps(d, _mm_set1_ps(0.215638f));
+			cb = _mm_mul_ps(d, _mm_add_ps(cb, _mm_set1_ps(-1.06021f)));
+			cb = _mm_add_ps(cb, _mm_set1_ps(0.848013f));
+
+			const __m128 centered = _mm_sub_ps(s, half);
+			const __m128 k = _mm_add_ps(_mm_mul_ps(ca, _mm_mul_ps(centered, centered)), cb);
+
+			s = _mm_add_ps(s, _mm_mul_ps(_mm_mul_ps(s, centered), _mm_mul_ps(_mm_sub_ps(s, one), k)));
+		}
+
+		__m128 q[4];
+
+		for (int i = 0; i < 4; ++i)
+			q[i] = _mm_add_ps(qa[i], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(qb[i], sign), qa[i]), s));
+
+		__m128 length = _mm_mul_ps(q[0], q[0]);
+		length = _mm_add_ps(length, _mm_mul_ps(q[1], q[1]));
+		length = _mm_add_ps(length, _mm_mul_ps(q[2], q[2]));
+		length = _mm_add_ps(length, _mm_mul_ps(q[3], q[3]));
+		length = _mm_sqrt_ps(length);
+
+		// Zero length (padding) results in zero instead of NaN
+		const __m128 valid = _mm_cmpgt_ps(length, zero);
+		const __m128 invLength = _mm_and_ps(_mm_div_ps(one, length), valid);
+
+		for (int i = 0; i < 4; ++i)
+			_mm_store_ps(quats->components[i] + n, _mm_mul_ps(q[i], invLength));
+	}
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+void quatSoAInterpolateAVX(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t, size_t begin, size_t end, int slerp)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	for (size_t n = begin; n < end; n += 8)
+	{
+		__m256 qa[4], qb[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			qa[i] = _mm256_load_ps(a->components[i] + n);
+			qb[i] = _mm256_load_ps(b->components[i] + n);
+		}
+
+		__m256 d = _mm256_mul_ps(qa[0], qb[0]);
+		d = _mm256_add_ps(d, _mm256_mul_ps(qa[1], qb[1]));
+		d = _mm256_add_ps(d, _mm256_mul_ps(qa[2], qb[2]));
+		d = _mm256_add_ps(d, _mm256_mul_ps(qa[3], qb[3]));
+
+		const __m256 sign = _mm256_and_ps(d, signMask);
+		d = _mm256_andnot_ps(signMask, d);
+
+		__m256 s = _mm256_loadu_ps(t + n);
+
+		if (slerp)
+		{
+			__m256 ca = _mm256_mul_ps(d, _mm256_set1_ps(-1.43519f));
+			ca = _mm256_mul_ps(d, _mm256_add_ps(ca, _mm256_set1_ps(3.55645f)));
+			ca = _mm256_mul_ps(d, _mm256_add_ps(ca, _mm256_set1_ps(-3.2452f)));
+			ca = _mm256_add_ps(ca, _mm256_set1_ps(1.0904f));
+
+			__m256 cb = _mm256_mul_ps(d, _mm256_set1_ps(0.215638f));
+			cb = _mm256_mul_ps(d, _mm256_add_ps(cb, _mm256_set1_ps(-1.06021f)));
+			cb = _mm256_add_ps(cb, _mm256_set1_ps(0.848013f));
+
+			const __m256 centered = _mm256_sub_ps(s, half);
+			const __m256 k = _mm256_add_ps(_mm256_mul_ps(ca, _mm256_mul_ps(centered, centered)), cb);
+
+			s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_mul_ps(s, centered), _mm256_mul_ps(_mm256_sub_ps(s, one), k)));
+		}
+
+		__m256 q[4];
+
+		for (int i = 0; i < 4; ++i)
+			q[i] = _mm256_add_ps(qa[i], _mm256_mul_ps(_mm256_sub_ps(_mm256_xor_ps(qb[i], sign), qa[i]), s));
+
+		__m256 length = _mm256_mul_ps(q[0], q[0]);
+		length = _mm256_add_ps(length, _mm256_mul_ps(q[1], q[1]));
+		length = _mm256_add_ps(length, _mm256_mul_ps(q[2], q[2]));
+		length = _mm256_add_ps(length, _mm256_mul_ps(q[3], q[3]));
+		length = _mm256_sqrt_ps(length);
+
+		const __m256 valid = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+		const __m256 invLength = _mm256_and_ps(_mm256_div_ps(one, length), valid);
+
+		for (int i = 0; i < 4; ++i)
+			_mm256_store_ps(quats->components[i] + n, _mm256_mul_ps(q[i], invLength));
+	}
+}
+#endif
+
+GLCQuatSoAInterpolateFunc quatGetSoAInterpolateFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return quatSoAInterpolateAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return quatSoAInterpolateSSE2;
+#endif
+	default:
+		return quatSoAInterpolateScalar;
+	}
+}
+
+// begin must be a multiple of GLC_MAT4_SOA_WIDTH. Whole blocks go through
+// the SIMD kernel, and what is left below end through the scalar one, so
+// only t[begin, end) is read and padding is left as is
+void quatSoAInterpolateRange(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t, size_t begin, size_t end, int slerp)
+{
+	static const GLCQuatSoAInterpolateFunc interpolate = quatGetSoAInterpolateFunc(linmathGetSIMDLevel());
+
+	if (begin >= end)
+		return;
+
+	const size_t blockEnd = end - (end - begin) % GLC_MAT4_SOA_WIDTH;
+
+	if (begin < blockEnd)
+		interpolate(quats, a, b, t, begin, blockEnd, slerp);
+
+	if (blockEnd < end)
+		quatSoAInterpolateScalar(quats, a, b, t, blockEnd, end, slerp);
+}
+
+// t must hold a->count values and needs no alignment, quats may be a or b
+void quatSoANlerp(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t)
+{
+	quatSoAInterpolateRange(quats, a, b, t, 0, a->count, 0);
+	quats->count = a->count;
+}
+
+// Not an exact slerp, but nlerp with t corrected by quatSlerpCorrection,
+// which keeps the angular error below 1e-3 radians. Use quatSlerp where
+// that is not enough. t is passed like for quatSoANlerp
+void quatSoASlerpApprox(GLCQuatSoA *quats, const GLCQuatSoA *a, const GLCQuatSoA *b, const float *t)
+{
+	quatSoAInterpolateRange(quats, a, b, t, 0, a->count, 1);
+	quats->count = a->count;
+}
+
+// Converts normalized quaternions into rotation matrices, matrices must have
+// at least the capacity of quats
+void quatSoAToMat4SoA(GLCMat4SoA *matrices, const GLCQuatSoA *quats)
+{
+	const float *qx = quats->components[0], *qy = quats->components[1];
+	const float *qz = quats->components[2], *qw = quats->components[3];
+
+	float **m = matrices->elements;
+
+	for (size_t n = 0; n < quats->capacity; ++n)
+	{
+		const float x = qx[n], y = qy[n], z = qz[n], w = qw[n];
+
+		m[0][n] = 1.0f - 2.0f * (y * y + z * z);
+		m[1][n] = 2.0f * (x * y + w * z);
+		m[2][n] = 2.0f * (x * z - w * y);
+		m[3][n] = 0.0f;
+
+		m[4][n] = 2.0f * (x * y - w * z);
+		m[5][n] = 1.0f - 2.0f * (x * x + z * z);
+		m[6][n] = 2.0f * (y * z + w * x);
+		m[7][n] = 0.0f;
+
+		m[8][n] = 2.0f * (x * z + w * y);
+		m[9][n] = 2.0f * (y * z - w * x);
+		m[10][n] = 1.0f - 2.0f * (x * x + y * y);
+		m[11][n] = 0.0f;
+
+		m[12][n] = 0.0f;
+		m[13][n] = 0.0f;
+		m[14][n] = 0.0f;
+		m[15][n] = 1.0f;
+	}
+
+	matrices->count = quats->count;
+}
+
+// Structure-of-arrays dual quaternions, the real and dual parts each stored
+// like GLCQuatSoA
+typedef struct GLCDualQuatSoA
+{
+	GLCQuatSoA real, dual;
+	size_t count, capacity;
+} GLCDualQuatSoA;
+
+int dualquatSoACreate(GLCDualQuatSoA *dqs, size_t count)
+{
+	memset(dqs, 0, sizeof(GLCDualQuatSoA));
+
+	if (!quatSoACreate(&dqs->real, count) || !quatSoACreate(&dqs->dual, count))
+	{
+		quatSoADestroy(&dqs->real);
+		quatSoADestroy(&dqs->dual);
+
+		return 0;
+	}
+
+	dqs->count = count;
+	dqs->capacity = dqs->real.capacity;
+
+	return 1;
+}
+
+void dualquatSoADestroy(GLCDualQuatSoA *dqs)
+{
+	quatSoADestroy(&dqs->real);
+	quatSoADestroy(&dqs->dual);
+
+	memset(dqs, 0, sizeof(GLCDualQuatSoA));
+}
+
+void dualquatSoASet(GLCDualQuatSoA *dqs, size_t index, const float dq[8])
+{
+	quatSoASet(&dqs->real, index, dq);
+	quatSoASet(&dqs->dual, index, dq + 4);
+}
+
+void dualquatSoAGet(const GLCDualQuatSoA *dqs, size_t index, float dq[8])
+{
+	quatSoAGet(&dqs->real, index, dq);
+	quatSoAGet(&dqs->dual, index, dq + 4);
+}
+
+typedef void (*GLCDualQuatSoANlerpFunc)(GLCDualQuatSoA *dqs, const GLCDualQuatSoA *a, const GLCDualQuatSoA *b, const float *t, size_t begin, size_t end);
+
+// Kernels blend dqs[n] between a[n] and b[n] by t[n] for n in [begin, end),
+// with the same range rules as the quaternion kernels. Each matches
+// dualquatNlerp, except that a zero length result is zero
+void dualquatSoANlerpScalar(GLCDualQuatSoA *dqs, const GLCDualQuatSoA *a, const GLCDualQuatSoA *b, const float *t, size_t begin, size_t end)
+{
+	for (size_t n = begin; n < end; ++n)
+	{
+		float da[8], db[8], dq[8];
+
+		dualquatSoAGet(a, n, da);
+		dualquatSoAGet(b, n, db);
+
+		const float sign = (quatDot(da, db) < 0.0f) ? -1.0f : 1.0f;
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] = da[i] + (db[i] * sign - da[i]) * t[n];
+
+		const float length = sqrtf(quatDot(dq, dq));
+		const float invLength = (length > 0.0f) ? (1.0f / length) : 0.0f;
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] *= invLength;
+
+		const float d = quatDot(dq, dq + 4);
+
+		for (int i = 0; i < 4; ++i)
+			dq[4 + i] -= dq[i] * d;
+
+		dualquatSoASet(dqs, n, dq);
+	}
+}
+
+#if defined(GLC_LINMATH_SSE2)
+void dualquatSoANlerpSSE2(GLCDualQuatSoA *dqs, const GLCDualQuatSoA *a, const GLCDualQuatSoA *b, const float *t, size_t begin, size_t end)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (size_t n = begin; n < end; n += 4)
+	{
+		__m128 da[8], db[8];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			da[i] = _mm_load_ps(a->real.components[i] + n);
+			db[i] = _mm_load_ps(b->real.components[i] + n);
+			da[4 + i] = _mm_load_ps(a->dual.components[i] + n);
+			db[4 + i] = _mm_load_ps(b->dual.components[i] + n);
+		}
+
+		__m128 d = _mm_mul_ps(da[0], db[0]);
+		d = _mm_add_ps(d, _mm_mul_ps(da[1], db[1]));
+		d = _mm_add_ps(d, _mm_mul_ps(da[2], db[2]));
+		d = _mm_add_ps(d, _mm_mul_ps(da[3], db[3]));
+
+		// The real parts pick the hemisphere, and the dual parts follow
+		const __m128 sign = _mm_and_ps(d, signMask);
+		const __m128 s = _mm_loadu_ps(t + n);
+
+		__m128 dq[8];
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] = _mm_add_ps(da[i], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(db[i], sign), da[i]), s));
+
+		__m128 length = _mm_mul_ps(dq[0], dq[0]);
+		length = _mm_add_ps(length, _mm_mul_ps(dq[1], dq[1]));
+		length = _mm_add_ps(length, _mm_mul_ps(dq[2], dq[2]));
+		length = _mm_add_ps(length, _mm_mul_ps(dq[3], dq[3]));
+		length = _mm_sqrt_ps(length);
+
+		const __m128 valid = _mm_cmpgt_ps(length, zero);
+		const __m128 invLength = _mm_and_ps(_mm_div_ps(one, length), valid);
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] = _mm_mul_ps(dq[i], invLength);
+
+		// Keep the dual part orthogonal to the real part
+		__m128 rd = _mm_mul_ps(dq[0], dq[4]);
+		rd = _mm_add_ps(rd, _mm_mul_ps(dq[1], dq[5]));
+		rd = _mm_add_ps(rd, _mm_mul_ps(dq[2], dq[6]));
+		rd = _mm_add_ps(rd, _mm_mul_ps(dq[3], dq[7]));
+
+		for (int i = 0; i < 4; ++i)
+		{
+			_mm_store_ps(dqs->real.components[i] + n, dq[i]);
+			_mm_store_ps(dqs->dual.components[i] + n, _mm_sub_ps(dq[4 + i], _mm_mul_ps(dq[i], rd)));
+		}
+	}
+}
+#endif
+
+#if defined(GLC_LINMATH_AVX)
+GLC_LINMATH_TARGET_AVX
+void dualquatSoANlerpAVX(GLCDualQuatSoA *dqs, const GLCDualQuatSoA *a, const GLCDualQuatSoA *b, const float *t, size_t begin, size_t end)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	for (size_t n = begin; n < end; n += 8)
+	{
+		__m256 da[8], db[8];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			da[i] = _mm256_load_ps(a->real.components[i] + n);
+			db[i] = _mm256_load_ps(b->real.components[i] + n);
+			da[4 + i] = _mm256_load_ps(a->dual.components[i] + n);
+			db[4 + i] = _mm256_load_ps(b->dual.components[i] + n);
+		}
+
+		__m256 d = _mm256_mul_ps(da[0], db[0]);
+		d = _mm256_add_ps(d, _mm256_mul_ps(da[1], db[1]));
+		d = _mm256_add_ps(d, _mm256_mul_ps(da[2], db[2]));
+		d = _mm256_add_ps(d, _mm256_mul_ps(da[3], db[3]));
+
+		const __m256 sign = _mm256_and_ps(d, signMask);
+		const __m256 s = _mm256_loadu_ps(t + n);
+
+		__m256 dq[8];
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] = _mm256_add_ps(da[i], _mm256_mul_ps(_mm256_sub_ps(_mm256_xor_ps(db[i], sign), da[i]), s));
+
+		__m256 length = _mm256_mul_ps(dq[0], dq[0]);
+		length = _mm256_add_ps(length, _mm256_mul_ps(dq[1], dq[1]));
+		length = _mm256_add_ps(length, _mm256_mul_ps(dq[2], dq[2]));
+		length = _mm256_add_ps(length, _mm256_mul_ps(dq[3], dq[3]));
+		length = _mm256_sqrt_ps(length);
+
+		const __m256 valid = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+		const __m256 invLength = _mm256_and_ps(_mm256_div_ps(one, length), valid);
+
+		for (int i = 0; i < 8; ++i)
+			dq[i] = _mm256_mul_ps(dq[i], invLength);
+
+		__m256 rd = _mm256_mul_ps(dq[0], dq[4]);
+		rd = _mm256_add_ps(rd, _mm256_mul_ps(dq[1], dq[5]));
+		rd = _mm256_add_ps(rd, _mm256_mul_ps(dq[2], dq[6]));
+		rd = _mm256_add_ps(rd, _mm256_mul_ps(dq[3], dq[7]));
+
+		for (int i = 0; i < 4; ++i)
+		{
+			_mm256_store_ps(dqs->real.components[i] + n, dq[i]);
+			_mm256_store_ps(dqs->dual.components[i] + n, _mm256_sub_ps(dq[4 + i], _mm256_mul_ps(dq[i], rd)));
+		}
+	}
+}
+#endif
+
+GLCDualQuatSoANlerpFunc dualquatGetSoANlerpFunc(GLCSIMDLevel level)
+{
+	switch (level)
+	{
+#if defined(GLC_LINMATH_AVX)
+	case GLC_SIMD_AVX:
+		return dualquatSoANlerpAVX;
+#endif
+#if defined(GLC_LINMATH_SSE2)
+	case GLC_SIMD_SSE2:
+		return dualquatSoANlerpSSE2;
+#endif
+	default:
+		return dualquatSoANlerpScalar;
+	}
+}
+
+// Dual quaternion linear blending of a[n] and b[n] by t[n], t must hold
+// a->count values and needs no alignment. dqs may be a or b
+void dualquatSoANlerp(GLCDualQuatSoA *dqs, const GLCDualQuatSoA *a, const GLCDualQuatSoA *b, const float *t)
+{
+	static const GLCDualQuatSoANlerpFunc nlerp = dualquatGetSoANlerpFunc(linmathGetSIMDLevel());
+
+	const size_t blockEnd = a->count / GLC_MAT4_SOA_WIDTH * GLC_MAT4_SOA_WIDTH;
+
+	if (blockEnd)
+		nlerp(dqs, a, b, t, 0, blockEnd);
+
+	if (blockEnd < a->count)
+		dualquatSoANlerpScalar(dqs, a, b, t, blockEnd, a->count);
+
+	dqs->count = dqs->real.count = dqs->dual.count = a->count;
+}
+
+// Converts normalized dual quaternions into rigid transforms, matrices must
+// have at least the capacity of dqs
+void dualquatSoAToMat4SoA(GLCMat4SoA *matrices, const GLCDualQuatSoA *dqs)
+{
+	quatSoAToMat4SoA(matrices, &dqs->real);
+
+	const float *rx = dqs->real.components[0], *ry = dqs->real.components[1];
+	const float *rz = dqs->real.components[2], *rw = dqs->real.components[3];
+	const float *dx = dqs->dual.components[0], *dy = dqs->dual.components[1];
+	const float *dz = dqs->dual.components[2], *dw = dqs->dual.components[3];
+
+	float **m = matrices->elements;
+
+	// translation = 2 * dual * conjugate(real), expanded
+	for (size_t n = 0; n < dqs->capacity; ++n)
+	{
+		m[12][n] = 2.0f * (dx[n] * rw[n] - dw[n] * rx[n] + dz[n] * ry[n] - dy[n] * rz[n]);
+		m[13][n] = 2.0f * (dy[n] * rw[n] - dw[n] * ry[n] + dx[n] * rz[n] - dz[n] * rx[n]);
+		m[14][n] = 2.0f * (dz[n] * rw[n] - dw[n] * rz[n] + dy[n] * rx[n] - dx[n] * ry[n]);
+	}
+
+	matrices->count = dqs->count;
+}
+
+#endif
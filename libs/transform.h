@@ -0,0 +1,239 @@
+#ifndef GLC_TRANSFORM_H
+#define GLC_TRANSFORM_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "linmath.h"
+#include "linmath_parallel.h"
+
+#define GLC_TRANSFORM_NO_PARENT -1
+
+// Transform hierarchy stored in flat arrays, where a parent always precedes
+// its children. world[i] = world[parent[i]] * local[i], and updating only
+// recomputes nodes whose local matrix or any ancestor changed.
+//
+// segments holds the start of every range of nodes without parents outside
+// of it, such that ranges can be updated independently. Adding a node with
+// a parent merges all segments after the parent's into one
+typedef struct GLCTransformHierarchy
+{
+	float (*local)[16];
+	float (*world)[16];
+	int32_t *parents;
+	uint8_t *dirty;
+	size_t count, capacity;
+
+	size_t *segments;
+	size_t segmentCount;
+} GLCTransformHierarchy;
+
+int transformHierarchyCreate(GLCTransformHierarchy *hierarchy, size_t capacity)
+{
+	memset(hierarchy, 0, sizeof(GLCTransformHierarchy));
+
+	if (capacity < 1)
+		capacity = 1;
+
+	hierarchy->local = (float(*)[16]) malloc(capacity * sizeof(*hierarchy->local));
+	hierarchy->world = (float(*)[16]) malloc(capacity * sizeof(*hierarchy->world));
+	hierarchy->parents = (int32_t*) malloc(capacity * sizeof(int32_t));
+	hierarchy->dirty = (uint8_t*) malloc(capacity * sizeof(uint8_t));
+	hierarchy->segments = (size_t*) malloc(capacity * sizeof(size_t));
+
+	if (!hierarchy->local || !hierarchy->world || !hierarchy->parents || !hierarchy->dirty || !hierarchy->segments)
+	{
+		free(hierarchy->local);
+		free(hierarchy->world);
+		free(hierarchy->parents);
+		free(hierarchy->dirty);
+		free(hierarchy->segments);
+
+		memset(hierarchy, 0, sizeof(GLCTransformHierarchy));
+
+		return 0;
+	}
+
+	hierarchy->capacity = capacity;
+
+	return 1;
+}
+
+void transformHierarchyDestroy(GLCTransformHierarchy *hierarchy)
+{
+	free(hierarchy->local);
+	free(hierarchy->world);
+	free(hierarchy->parents);
+	free(hierarchy->dirty);
+	free(hierarchy->segments);
+
+	memset(hierarchy, 0, sizeof(GLCTransformHierarchy));
+}
+
+int transformHierarchyReserve(GLCTransformHierarchy *hierarchy, size_t capacity)
+{
+	if (capacity <= hierarchy->capacity)
+		return 1;
+
+	float (*local)[16] = (float(*)[16]) realloc(hierarchy->local, capacity * sizeof(*hierarchy->local));
+	if (local)
+		hierarchy->local = local;
+
+	float (*world)[16] = (float(*)[16]) realloc(hierarchy->world, capacity * sizeof(*hierarchy->world));
+	if (world)
+		hierarchy->world = world;
+
+	int32_t *parents = (int32_t*) realloc(hierarchy->parents, capacity * sizeof(int32_t));
+	if (parents)
+		hierarchy->parents = parents;
+
+	uint8_t *dirty = (uint8_t*) realloc(hierarchy->dirty, capacity * sizeof(uint8_t));
+	if (dirty)
+		hierarchy->dirty = dirty;
+
+	size_t *segments = (size_t*) realloc(hierarchy->segments, capacity * sizeof(size_t));
+	if (segments)
+		hierarchy->segments = segments;
+
+	if (!local || !world || !parents || !dirty || !segments)
+		return 0;
+
+	hierarchy->capacity = capacity;
+
+	return 1;
+}
+
+// Returns the index of the new node, or -1 on failure. parent must be
+// GLC_TRANSFORM_NO_PARENT or the index of an existing node
+int32_t transformHierarchyAdd(GLCTransformHierarchy *hierarchy, int32_t parent, const float local[16])
+{
+	if ((parent != GLC_TRANSFORM_NO_PARENT) && ((parent < 0) || ((size_t) parent >= hierarchy->count)))
+		return -1;
+
+	if (hierarchy->count == hierarchy->capacity)
+	{
+		if (!transformHierarchyReserve(hierarchy, hierarchy->capacity * 2))
+			return -1;
+	}
+
+	const size_t index = hierarchy->count++;
+
+	memcpy(hierarchy->local[index], local, sizeof(hierarchy->local[index]));
+	hierarchy->parents[index] = parent;
+	hierarchy->dirty[index] = 1;
+
+	if (parent == GLC_TRANSFORM_NO_PARENT)
+	{
+		hierarchy->segments[hierarchy->segmentCount++] = index;
+	}
+	else
+	{
+		// Segments starting after the parent now contain a child of it
+		while ((hierarchy->segmentCount > 1) && (hierarchy->segments[hierarchy->segmentCount - 1] > (size_t) parent))
+			--hierarchy->segmentCount;
+	}
+
+	return (int32_t) index;
+}
+
+void transformHierarchySetLocal(GLCTransformHierarchy *hierarchy, int32_t index, const float local[16])
+{
+	memcpy(hierarchy->local[index], local, sizeof(hierarchy->local[index]));
+	hierarchy->dirty[index] = 1;
+}
+
+// Returns the local matrix for modifying it in place, marking it dirty
+float* transformHierarchyEditLocal(GLCTransformHierarchy *hierarchy, int32_t index)
+{
+	hierarchy->dirty[index] = 1;
+	return hierarchy->local[index];
+}
+
+const float* transformHierarchyGetWorld(const GLCTransformHierarchy *hierarchy, int32_t index)
+{
+	return hierarchy->world[index];
+}
+
+// Updates the nodes in [begin, end), which must not have parents before
+// begin unless those are already up to date. Returns the updated node count
+size_t transformHierarchyUpdateRange(GLCTransformHierarchy *hierarchy, size_t begin, size_t end)
+{
+	const int32_t *parents = hierarchy->parents;
+	uint8_t *dirty = hierarchy->dirty;
+
+	size_t updated = 0;
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		const int32_t parent = parents[i];
+
+		// Parents are processed first, so their flag already includes their ancestors
+		if ((parent != GLC_TRANSFORM_NO_PARENT) && ((size_t) parent >= begin))
+			dirty[i] |= dirty[parent];
+
+		if (!dirty[i])
+			continue;
+
+		if (parent == GLC_TRANSFORM_NO_PARENT)
+			memcpy(hierarchy->world[i], hierarchy->local[i], sizeof(hierarchy->world[i]));
+		else
+			mat4Multiply(hierarchy->world[i], hierarchy->world[parent], hierarchy->local[i]);
+
+		++updated;
+	}
+
+	memset(dirty + begin, 0, end - begin);
+
+	return updated;
+}
+
+size_t transformHierarchyUpdate(GLCTransformHierarchy *hierarchy)
+{
+	return transformHierarchyUpdateRange(hierarchy, 0, hierarchy->count);
+}
+
+// Splits the hierarchy at segment boundaries across threads
+size_t transformHierarchyUpdateParallel(GLCTransformHierarchy *hierarchy)
+{
+	const size_t count = hierarchy->count;
+	const size_t segmentCount = hierarchy->segmentCount;
+
+	if ((count < GLC_LINMATH_PARALLEL_MIN_COUNT) || (segmentCount < 2))
+		return transformHierarchyUpdate(hierarchy);
+
+	// Groups consecutive segments into ranges of roughly equal node counts,
+	// a few per thread to balance uneven subtrees
+	const size_t rangeTarget = linmathGetThreadCount() * 4;
+	const size_t rangeSize = (count + rangeTarget - 1) / rangeTarget;
+
+	std::vector<size_t> boundaries;
+	boundaries.reserve(rangeTarget + 1);
+
+	for (size_t s = 0; s < segmentCount; ++s)
+	{
+		const size_t start = hierarchy->segments[s];
+
+		if (boundaries.empty() || ((start - boundaries.back()) >= rangeSize))
+			boundaries.push_back(start);
+	}
+
+	boundaries.push_back(count);
+
+	std::vector<size_t> updated(boundaries.size() - 1, 0);
+
+	linmathParallelFor(boundaries.size() - 1, 1, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t r = begin; r < end; ++r)
+			updated[r] = transformHierarchyUpdateRange(hierarchy, boundaries[r], boundaries[r + 1]);
+	});
+
+	size_t total = 0;
+
+	for (size_t r = 0; r < updated.size(); ++r)
+		total += updated[r];
+
+	return total;
+}
+
+#endif
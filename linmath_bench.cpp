@@ -0,0 +1,1682 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <chrono>
+
+#include "linmath.h"
+#include "linmath_parallel.h"
+#include "quaternion.h"
+#include "frustum.h"
+#include "transform.h"
+
+static const int matrixCount = 1024;
+static const int iterations  = 2000;
+
+static const size_t batchCount = 65536;
+static const int batchIterations = 50;
+
+static float lhsMatrices[matrixCount][16];
+static float rhsMatrices[matrixCount][16];
+static float resultMatrices[matrixCount][16];
+
+float randomFloat(float min, float max)
+{
+	return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+void randomMatrices()
+{
+	srand(1234);
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		for (int j = 0; j < 16; ++j)
+		{
+			lhsMatrices[i][j] = randomFloat(-10.0f, 10.0f);
+			rhsMatrices[i][j] = randomFloat(-10.0f, 10.0f);
+		}
+	}
+}
+
+// Compares a kernel against the scalar reference, returns the number of
+// matrices exceeding the tolerance. Results are expected to be bit-exact,
+// the tolerance only allows for compilers contracting the scalar path into FMAs
+int verifyMultiply(const char *name, GLCMat4MultiplyFunc multiply, float tolerance)
+{
+	int bitExact = 0, failed = 0;
+	float maxError = 0.0f;
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		float expected[16], actual[16];
+
+		mat4MultiplyScalar(expected, lhsMatrices[i], rhsMatrices[i]);
+		multiply(actual, lhsMatrices[i], rhsMatrices[i]);
+
+		if (memcmp(expected, actual, sizeof(expected)) == 0)
+			++bitExact;
+
+		float error = 0.0f;
+		for (int j = 0; j < 16; ++j)
+		{
+			const float diff = fabsf(expected[j] - actual[j]);
+			if (diff > error)
+				error = diff;
+		}
+
+		if (error > maxError)
+			maxError = error;
+
+		if (error > tolerance)
+			++failed;
+	}
+
+	// Writing the result into an operand must not change the result
+	float aliased[16], expected[16];
+	memcpy(aliased, lhsMatrices[0], sizeof(aliased));
+
+	multiply(expected, lhsMatrices[0], rhsMatrices[0]);
+	multiply(aliased, aliased, rhsMatrices[0]);
+
+	if (memcmp(expected, aliased, sizeof(expected)) != 0)
+		++failed;
+
+	printf("verify %-8s bit-exact %d/%d, max error %g, %s\n",
+	       name, bitExact, matrixCount, maxError, failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+#define GLC_BENCH_MAX_RESULTS 256
+
+typedef struct GLCBenchResult
+{
+	char name[64];
+	size_t opsPerCall;
+	int repetitions;
+	double mean, min, p50, p90, p99, max;
+} GLCBenchResult;
+
+static GLCBenchResult benchResults[GLC_BENCH_MAX_RESULTS];
+static size_t benchResultCount = 0;
+
+int compareDouble(const void *lhs, const void *rhs)
+{
+	const double a = *(const double*) lhs, b = *(const double*) rhs;
+	return (a > b) - (a < b);
+}
+
+// Nearest rank percentile of sorted samples
+double percentile(const double *sorted, size_t count, double p)
+{
+	size_t rank = (size_t) ceil(p / 100.0 * (double) count);
+	return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+// Runs func(), which performs opsPerCall operations, repeatedly and reports
+// the time per operation. Every repetition is timed on its own, such that
+// percentiles show the spread caused by interrupts and frequency changes
+template<typename Func>
+double benchmark(const char *name, int repetitions, size_t opsPerCall, Func func)
+{
+	// Warm up caches, branch predictors and clock frequency before timing
+	const int warmUps = (repetitions / 10) > 0 ? (repetitions / 10) : 1;
+
+	for (int n = 0; n < warmUps; ++n)
+		func();
+
+	double *samples = (double*) malloc(repetitions * sizeof(double));
+	double total = 0.0;
+
+	for (int n = 0; n < repetitions; ++n)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		func();
+
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		samples[n] = std::chrono::duration<double, std::nano>(end - start).count() / (double) opsPerCall;
+		total += samples[n];
+	}
+
+	qsort(samples, repetitions, sizeof(double), compareDouble);
+
+	GLCBenchResult result;
+	memset(&result, 0, sizeof(result));
+
+	snprintf(result.name, sizeof(result.name), "%s", name);
+	result.opsPerCall = opsPerCall;
+	result.repetitions = repetitions;
+	result.mean = total / (double) repetitions;
+	result.min = samples[0];
+	result.p50 = percentile(samples, repetitions, 50.0);
+	result.p90 = percentile(samples, repetitions, 90.0);
+	result.p99 = percentile(samples, repetitions, 99.0);
+	result.max = samples[repetitions - 1];
+
+	free(samples);
+
+	if (benchResultCount < GLC_BENCH_MAX_RESULTS)
+		benchResults[benchResultCount++] = result;
+
+	printf("bench  %-24s %8.3f ns/op %12.0f ops/s  p50 %8.3f  p90 %8.3f  p99 %8.3f\n",
+	       name, result.mean, 1.0e9 / result.mean, result.p50, result.p90, result.p99);
+
+	return result.mean;
+}
+
+// Writes one result per line, which --compare relies on when reading it back
+int writeBenchResults(const char *path)
+{
+	FILE *file = fopen(path, "w");
+
+	if (!file)
+	{
+		fprintf(stderr, "Failed opening %s\n", path);
+		return 0;
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"simd\": \"%s\",\n", linmathGetSIMDLevelString(linmathGetSIMDLevel()));
+	fprintf(file, "\t\"threads\": %u,\n", linmathGetThreadCount());
+	fprintf(file, "\t\"results\": [\n");
+
+	for (size_t i = 0; i < benchResultCount; ++i)
+	{
+		const GLCBenchResult *result = benchResults + i;
+
+		fprintf(file, "\t\t{\"name\": \"%s\", \"ops_per_call\": %zu, \"repetitions\": %d, "
+		              "\"ns_per_op\": %.4f, \"ops_per_sec\": %.0f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+		        result->name, result->opsPerCall, result->repetitions,
+		        result->mean, 1.0e9 / result->mean, result->min, result->p50, result->p90, result->p99, result->max,
+		        ((i + 1) < benchResultCount) ? "," : "");
+	}
+
+	fprintf(file, "\t]\n");
+	fprintf(file, "}\n");
+
+	fclose(file);
+
+	return 1;
+}
+
+// Reads the name and p50 of every result line written by writeBenchResults
+size_t readBenchResults(const char *path, GLCBenchResult *results, size_t maxCount)
+{
+	FILE *file = fopen(path, "r");
+
+	if (!file)
+	{
+		fprintf(stderr, "Failed opening %s\n", path);
+		return 0;
+	}
+
+	char line[512];
+	size_t count = 0;
+
+	while (fgets(line, sizeof(line), file) && (count < maxCount))
+	{
+		const char *name = strstr(line, "\"name\": \"");
+		const char *p50 = strstr(line, "\"p50\": ");
+
+		if (!name || !p50)
+			continue;
+
+		name += strlen("\"name\": \"");
+
+		const char *nameEnd = strchr(name, '"');
+		if (!nameEnd)
+			continue;
+
+		GLCBenchResult *result = results + count++;
+		memset(result, 0, sizeof(GLCBenchResult));
+
+		snprintf(result->name, sizeof(result->name), "%.*s", (int) (nameEnd - name), name);
+		result->p50 = atof(p50 + strlen("\"p50\": "));
+	}
+
+	fclose(file);
+
+	return count;
+}
+
+// Compares the medians of two runs, returns the number of functions that
+// became slower by more than threshold percent
+int compareBenchResults(const char *baselinePath, const char *currentPath, double threshold)
+{
+	static GLCBenchResult baseline[GLC_BENCH_MAX_RESULTS], current[GLC_BENCH_MAX_RESULTS];
+
+	const size_t baselineCount = readBenchResults(baselinePath, baseline, GLC_BENCH_MAX_RESULTS);
+	const size_t currentCount = readBenchResults(currentPath, current, GLC_BENCH_MAX_RESULTS);
+
+	if (!baselineCount || !currentCount)
+		return 1;
+
+	int regressed = 0;
+
+	for (size_t i = 0; i < currentCount; ++i)
+	{
+		const GLCBenchResult *before = NULL;
+
+		for (size_t j = 0; j < baselineCount; ++j)
+		{
+			if (strcmp(baseline[j].name, current[i].name) == 0)
+			{
+				before = baseline + j;
+				break;
+			}
+		}
+
+		if (!before)
+		{
+			printf("new    %-24s %8.3f ns/op\n", current[i].name, current[i].p50);
+			continue;
+		}
+
+		const double change = (current[i].p50 - before->p50) / before->p50 * 100.0;
+		const int slower = change > threshold;
+
+		regressed += slower;
+
+		printf("%s %-24s %8.3f -> %8.3f ns/op %+7.1f%%\n",
+		       slower ? "SLOWER" : (change < -threshold) ? "faster" : "same  ",
+		       current[i].name, before->p50, current[i].p50, change);
+	}
+
+	printf("%d of %zu functions slower by more than %g%%\n", regressed, currentCount, threshold);
+
+	return regressed;
+}
+
+double benchmarkMultiply(const char *name, GLCMat4MultiplyFunc multiply)
+{
+	char label[64];
+	snprintf(label, sizeof(label), "mat4Multiply %s", name);
+
+	return benchmark(label, iterations, matrixCount, [=]()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			multiply(resultMatrices[i], lhsMatrices[i], rhsMatrices[i]);
+	});
+}
+
+int verifyBatch(const float *models, const GLCMat4SoA *soaResult, const float *batchResult)
+{
+	int failed = 0;
+
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		float expected[16], actual[16];
+		mat4MultiplyScalar(expected, lhsMatrices[0], models + i * 16);
+
+		mat4SoAGet(soaResult, i, actual);
+
+		if (memcmp(expected, actual, sizeof(expected)) != 0)
+			++failed;
+
+		if (memcmp(expected, batchResult + i * 16, sizeof(expected)) != 0)
+			++failed;
+	}
+
+	printf("verify %-24s %s\n", "batch", failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+int benchmarkBatch()
+{
+	float *models = (float*) malloc(batchCount * 16 * sizeof(float));
+	float *results = (float*) malloc(batchCount * 16 * sizeof(float));
+
+	GLCMat4SoA soaModels, soaResults;
+
+	if (!models || !results || !mat4SoACreate(&soaModels, batchCount) || !mat4SoACreate(&soaResults, batchCount))
+	{
+		fprintf(stderr, "Failed allocating batch matrices\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		memcpy(models + i * 16, rhsMatrices[i % matrixCount], 16 * sizeof(float));
+		mat4SoASet(&soaModels, i, models + i * 16);
+	}
+
+	const float *viewProjection = lhsMatrices[0];
+
+	benchmark("mat4Multiply loop", batchIterations, batchCount, [=]()
+	{
+		for (size_t i = 0; i < batchCount; ++i)
+			mat4Multiply(results + i * 16, viewProjection, models + i * 16);
+	});
+
+	benchmark("mat4MultiplyBatch", batchIterations, batchCount, [=]()
+	{
+		mat4MultiplyBatch(results, viewProjection, models, batchCount);
+	});
+
+	benchmark("mat4MultiplyBatchParallel", batchIterations, batchCount, [=]()
+	{
+		mat4MultiplyBatchParallel(results, viewProjection, models, batchCount);
+	});
+
+	benchmark("mat4SoAMultiplyBatch", batchIterations, batchCount, [&]()
+	{
+		mat4SoAMultiplyBatch(&soaResults, viewProjection, &soaModels);
+	});
+
+	benchmark("mat4SoAMultiplyBatchPar", batchIterations, batchCount, [&]()
+	{
+		mat4SoAMultiplyBatchParallel(&soaResults, viewProjection, &soaModels);
+	});
+
+	const int failed = verifyBatch(models, &soaResults, results);
+
+	mat4SoADestroy(&soaResults);
+	mat4SoADestroy(&soaModels);
+
+	free(results);
+	free(models);
+
+	return failed;
+}
+
+// The transform builders as they were before being fused, building a full
+// temporary, multiplying and copying the result back
+void mat4TranslateReference(float matrix[16], float x, float y, float z)
+{
+	float transform[16], result[16];
+
+	mat4Translation(transform, x, y, z);
+	mat4Multiply(result, matrix, transform);
+
+	memcpy(matrix, result, sizeof(result));
+}
+
+void mat4ScaleReference(float matrix[16], float sx, float sy, float sz)
+{
+	float transform[16], result[16];
+
+	mat4Scaling(transform, sx, sy, sz);
+	mat4Multiply(result, matrix, transform);
+
+	memcpy(matrix, result, sizeof(result));
+}
+
+void mat4RotateReference(float matrix[16], float angle, float x, float y, float z)
+{
+	float transform[16], result[16];
+
+	mat4Rotation(transform, angle, x, y, z);
+	mat4Multiply(result, matrix, transform);
+
+	memcpy(matrix, result, sizeof(result));
+}
+
+void mat4PerspectiveViewModelReference(float matrix[16], float fov, float aspect, float zNear, float zFar, const float view[16], const float model[16])
+{
+	float projection[16], temp[16];
+
+	mat4Perspective(projection, fov, aspect, zNear, zFar);
+
+	mat4Multiply(temp, projection, view);
+	mat4Multiply(matrix, temp, model);
+}
+
+float maxDifference(const float lhs[16], const float rhs[16])
+{
+	float difference = 0.0f;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const float diff = fabsf(lhs[i] - rhs[i]);
+		if (diff > difference)
+			difference = diff;
+	}
+
+	return difference;
+}
+
+int verifyTransforms()
+{
+	float maxTranslate = 0.0f, maxScale = 0.0f, maxRotate = 0.0f, maxMVP = 0.0f;
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		const float *m = lhsMatrices[i];
+		const float *r = rhsMatrices[i];
+
+		float expected[16], actual[16];
+
+		memcpy(expected, m, sizeof(expected));
+		memcpy(actual, m, sizeof(actual));
+		mat4TranslateReference(expected, r[0], r[1], r[2]);
+		mat4Translate(actual, r[0], r[1], r[2]);
+		maxTranslate = fmaxf(maxTranslate, maxDifference(expected, actual));
+
+		memcpy(expected, m, sizeof(expected));
+		memcpy(actual, m, sizeof(actual));
+		mat4ScaleReference(expected, r[0], r[1], r[2]);
+		mat4Scale(actual, r[0], r[1], r[2]);
+		maxScale = fmaxf(maxScale, maxDifference(expected, actual));
+
+		const float length = sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+
+		memcpy(expected, m, sizeof(expected));
+		memcpy(actual, m, sizeof(actual));
+		mat4RotateReference(expected, r[3], r[0] / length, r[1] / length, r[2] / length);
+		mat4Rotate(actual, r[3], r[0] / length, r[1] / length, r[2] / length);
+		maxRotate = fmaxf(maxRotate, maxDifference(expected, actual));
+
+		float view[16], model[16];
+		mat4Identity(view);
+		mat4Translate(view, 0.0f, 0.0f, -3.0f);
+		mat4Rotate(view, r[4], 1.0f, 0.0f, 0.0f);
+		mat4Rotation(model, r[5], 0.0f, 1.0f, 0.0f);
+
+		float viewProjection[16];
+		mat4PerspectiveMultiply(viewProjection, 70.0f, 4.0f / 3.0f, 0.01f, 10.0f, view);
+
+		mat4PerspectiveViewModelReference(expected, 70.0f, 4.0f / 3.0f, 0.01f, 10.0f, view, model);
+		mat4Multiply(actual, viewProjection, model);
+		maxMVP = fmaxf(maxMVP, maxDifference(expected, actual));
+	}
+
+	// Translate and scale only skip multiplications by 0 and 1, rotate and the
+	// MVP chain reassociate and may differ by a few ulps
+	const int failed = (maxTranslate > 0.0f) + (maxScale > 0.0f) + (maxRotate > 1.0e-3f) + (maxMVP > 1.0e-3f);
+
+	printf("verify %-24s max error translate %g, scale %g, rotate %g, mvp %g, %s\n",
+	       "transforms", maxTranslate, maxScale, maxRotate, maxMVP, failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+void benchmarkTransforms()
+{
+	benchmark("mat4TranslateReference", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4TranslateReference(resultMatrices[i], rhsMatrices[i][0], rhsMatrices[i][1], rhsMatrices[i][2]);
+	});
+
+	benchmark("mat4Translate", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Translate(resultMatrices[i], rhsMatrices[i][0], rhsMatrices[i][1], rhsMatrices[i][2]);
+	});
+
+	benchmark("mat4ScaleReference", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4ScaleReference(resultMatrices[i], 1.0001f, 0.9999f, 1.0001f);
+	});
+
+	benchmark("mat4Scale", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Scale(resultMatrices[i], 1.0001f, 0.9999f, 1.0001f);
+	});
+
+	benchmark("mat4RotateReference", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4RotateReference(resultMatrices[i], rhsMatrices[i][3], 0.0f, 1.0f, 0.0f);
+	});
+
+	benchmark("mat4Rotate", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Rotate(resultMatrices[i], rhsMatrices[i][3], 0.0f, 1.0f, 0.0f);
+	});
+
+	benchmark("mat4PerspectiveViewModelR", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4PerspectiveViewModelReference(resultMatrices[i], 70.0f, 4.0f / 3.0f, 0.01f, 10.0f, lhsMatrices[i], rhsMatrices[i]);
+	});
+
+	// The view projection is built once per call, like once per frame, and
+	// reused for every model
+	benchmark("mat4MultiplyViewProj", iterations, matrixCount, []()
+	{
+		float viewProjection[16];
+		mat4PerspectiveMultiply(viewProjection, 70.0f, 4.0f / 3.0f, 0.01f, 10.0f, lhsMatrices[0]);
+
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Multiply(resultMatrices[i], viewProjection, rhsMatrices[i]);
+	});
+}
+
+float identityError(const float matrix[16])
+{
+	float identity[16];
+	mat4Identity(identity);
+
+	return maxDifference(matrix, identity);
+}
+
+void randomRigidMatrix(float matrix[16], const float r[16])
+{
+	const float length = sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+
+	mat4Translation(matrix, r[4], r[5], r[6]);
+	mat4Rotate(matrix, r[3], r[0] / length, r[1] / length, r[2] / length);
+}
+
+int verifyInverse()
+{
+	static const GLCSIMDLevel levels[] = { GLC_SIMD_SCALAR, GLC_SIMD_SSE2 };
+
+	int failed = 0;
+
+	for (size_t l = 0; l < sizeof(levels) / sizeof(*levels); ++l)
+	{
+		const GLCMat4InverseFunc inverse = mat4GetInverseFunc(levels[l]);
+
+		if ((levels[l] != GLC_SIMD_SCALAR) && (inverse == mat4InverseScalar))
+			continue;
+
+		float maxError = 0.0f;
+
+		for (int i = 0; i < matrixCount; ++i)
+		{
+			float inv[16], product[16];
+
+			if (!inverse(inv, lhsMatrices[i]))
+				continue;
+
+			mat4Multiply(product, lhsMatrices[i], inv);
+			maxError = fmaxf(maxError, identityError(product));
+		}
+
+		// Random matrices are poorly conditioned now and then
+		const int levelFailed = maxError > 1.0e-2f;
+		failed += levelFailed;
+
+		char label[64];
+		snprintf(label, sizeof(label), "mat4Inverse %s", linmathGetSIMDLevelString(levels[l]));
+
+		printf("verify %-24s max error %g, %s\n", label, maxError, levelFailed ? "FAILED" : "ok");
+	}
+
+	float maxAffine = 0.0f, maxRigid = 0.0f, maxNormal = 0.0f;
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		float rigid[16], affine[16];
+		randomRigidMatrix(rigid, rhsMatrices[i]);
+
+		memcpy(affine, rigid, sizeof(affine));
+		mat4Scale(affine, 0.5f + fabsf(lhsMatrices[i][0]), 0.5f + fabsf(lhsMatrices[i][1]), 0.5f + fabsf(lhsMatrices[i][2]));
+
+		float expected[16], actual[16];
+
+		mat4InverseScalar(expected, rigid);
+		mat4InverseRigid(actual, rigid);
+		maxRigid = fmaxf(maxRigid, maxDifference(expected, actual));
+
+		mat4InverseScalar(expected, affine);
+		mat4InverseAffine(actual, affine);
+		maxAffine = fmaxf(maxAffine, maxDifference(expected, actual));
+
+		float normal[9];
+		mat3NormalMatrix(normal, affine);
+
+		for (int c = 0; c < 3; ++c)
+			for (int r = 0; r < 3; ++r)
+				maxNormal = fmaxf(maxNormal, fabsf(normal[c * 3 + r] - expected[r * 4 + c]));
+	}
+
+	const int derivedFailed = (maxAffine > 1.0e-3f) + (maxRigid > 1.0e-3f) + (maxNormal > 1.0e-3f);
+	failed += derivedFailed;
+
+	printf("verify %-24s max error affine %g, rigid %g, normal %g, %s\n",
+	       "inverse variants", maxAffine, maxRigid, maxNormal, derivedFailed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+void benchmarkInverse()
+{
+	static float rigidMatrices[matrixCount][16];
+
+	for (int i = 0; i < matrixCount; ++i)
+		randomRigidMatrix(rigidMatrices[i], rhsMatrices[i]);
+
+	benchmark("mat4InverseScalar", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4InverseScalar(resultMatrices[i], rigidMatrices[i]);
+	});
+
+	benchmark("mat4Inverse", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Inverse(resultMatrices[i], rigidMatrices[i]);
+	});
+
+	benchmark("mat4InverseAffine", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4InverseAffine(resultMatrices[i], rigidMatrices[i]);
+	});
+
+	benchmark("mat4InverseRigid", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4InverseRigid(resultMatrices[i], rigidMatrices[i]);
+	});
+
+	benchmark("mat3NormalMatrix", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat3NormalMatrix(resultMatrices[i], rigidMatrices[i]);
+	});
+}
+
+void randomQuat(float q[4], const float r[16])
+{
+	const float length = sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+	quatRotation(q, r[3], r[0] / length, r[1] / length, r[2] / length);
+}
+
+// Angle between two rotations in radians, using the chord length as acos
+// is too imprecise near 1
+float quatAngle(const float a[4], const float b[4])
+{
+	float difference = 0.0f, sum = 0.0f;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		difference += (a[i] - b[i]) * (a[i] - b[i]);
+		sum += (a[i] + b[i]) * (a[i] + b[i]);
+	}
+
+	const float chord = sqrtf(fminf(difference, sum));
+	return 4.0f * asinf(fminf(chord * 0.5f, 1.0f));
+}
+
+int verifyQuaternions()
+{
+	float maxRotation = 0.0f, maxRoundTrip = 0.0f, maxMultiply = 0.0f, maxDual = 0.0f;
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		const float *r = rhsMatrices[i];
+		const float length = sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+
+		float expected[16], actual[16];
+		float q[4], qm[4];
+
+		mat4Rotation(expected, r[3], r[0] / length, r[1] / length, r[2] / length);
+		randomQuat(q, r);
+		quatToMat4(actual, q);
+		maxRotation = fmaxf(maxRotation, maxDifference(expected, actual));
+
+		quatFromMat4(qm, expected);
+		maxRoundTrip = fmaxf(maxRoundTrip, quatAngle(q, qm));
+
+		float q2[4], combined[4], rotation2[16];
+		randomQuat(q2, lhsMatrices[i]);
+		quatToMat4(rotation2, q2);
+		quatMultiply(combined, q, q2);
+
+		mat4Multiply(expected, actual, rotation2);
+		quatToMat4(actual, combined);
+		maxMultiply = fmaxf(maxMultiply, maxDifference(expected, actual));
+
+		float dq[8];
+		dualquatFromQuatTranslation(dq, q, r[4], r[5], r[6]);
+
+		mat4Translation(expected, r[4], r[5], r[6]);
+		quatToMat4(rotation2, q);
+		mat4Multiply(expected, expected, rotation2);
+
+		dualquatToMat4(actual, dq);
+		maxDual = fmaxf(maxDual, maxDifference(expected, actual));
+	}
+
+	int failed = (maxRotation > 1.0e-5f) + (maxRoundTrip > 1.0e-5f) + (maxMultiply > 1.0e-5f) + (maxDual > 1.0e-4f);
+
+	printf("verify %-24s max error rotation %g, round trip %g, multiply %g, dual %g, %s\n",
+	       "quaternion", maxRotation, maxRoundTrip, maxMultiply, maxDual, failed ? "FAILED" : "ok");
+
+	return failed;
+}
+
+// Every kernel on a count that leaves padding lanes, and a t that is not
+// aligned, as callers are free to pass any float array
+int verifyQuatSoAKernels()
+{
+	static const GLCSIMDLevel levels[] = { GLC_SIMD_SCALAR, GLC_SIMD_SSE2, GLC_SIMD_AVX };
+	static const size_t count = GLC_MAT4_SOA_WIDTH * 2 - 3;
+
+	GLCQuatSoA a, b, expected, actual;
+
+	if (!quatSoACreate(&a, count) || !quatSoACreate(&b, count) || !quatSoACreate(&expected, count) || !quatSoACreate(&actual, count))
+	{
+		fprintf(stderr, "Failed allocating quaternions\n");
+		return 1;
+	}
+
+	float *memory = (float*) malloc((a.capacity + 1) * sizeof(float));
+	float *t = memory + 1;
+
+	for (size_t i = 0; i < a.capacity; ++i)
+	{
+		float q[4];
+
+		if (i < count)
+		{
+			randomQuat(q, rhsMatrices[i % matrixCount]);
+			quatSoASet(&a, i, q);
+
+			randomQuat(q, lhsMatrices[(i * 3) % matrixCount]);
+			quatSoASet(&b, i, q);
+		}
+
+		t[i] = (float) i / (float) a.capacity;
+	}
+
+	quatSoAInterpolateScalar(&expected, &a, &b, t, 0, a.capacity, 1);
+
+	int failed = 0;
+
+	for (size_t l = 0; l < sizeof(levels) / sizeof(*levels); ++l)
+	{
+		const GLCQuatSoAInterpolateFunc interpolate = quatGetSoAInterpolateFunc(levels[l]);
+
+		if ((levels[l] != GLC_SIMD_SCALAR) && (interpolate == quatSoAInterpolateScalar))
+			continue;
+		if ((levels[l] == GLC_SIMD_AVX) && (linmathGetSIMDLevel() != GLC_SIMD_AVX))
+			continue;
+
+		interpolate(&actual, &a, &b, t, 0, a.capacity, 1);
+
+		float maxError = 0.0f;
+		int paddingFailed = 0;
+
+		for (size_t i = 0; i < a.capacity; ++i)
+		{
+			float qe[4], qa[4];
+
+			quatSoAGet(&expected, i, qe);
+			quatSoAGet(&actual, i, qa);
+
+			for (int c = 0; c < 4; ++c)
+			{
+				if (i < count)
+					maxError = fmaxf(maxError, fabsf(qe[c] - qa[c]));
+				else
+					paddingFailed += (qe[c] != 0.0f) || (qa[c] != 0.0f);
+			}
+		}
+
+		const int levelFailed = (maxError > 1.0e-5f) || paddingFailed;
+		failed += levelFailed;
+
+		printf("verify %-24s %-6s unaligned t, max error %g, padding %s, %s\n", "quatSoAInterpolate", linmathGetSIMDLevelString(levels[l]),
+		       maxError, paddingFailed ? "not zero" : "zero", levelFailed ? "FAILED" : "ok");
+	}
+
+	// The public API with t holding exactly count values, the tail past the
+	// last whole block goes through the scalar kernel
+	float *exactT = (float*) malloc(count * sizeof(float));
+	memcpy(exactT, t, count * sizeof(float));
+
+	quatSoASlerpApprox(&actual, &a, &b, exactT);
+
+	float maxTailError = 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float qe[4], qa[4];
+
+		quatSoAGet(&expected, i, qe);
+		quatSoAGet(&actual, i, qa);
+
+		for (int c = 0; c < 4; ++c)
+			maxTailError = fmaxf(maxTailError, fabsf(qe[c] - qa[c]));
+	}
+
+	const int tailFailed = maxTailError > 1.0e-5f;
+	failed += tailFailed;
+
+	printf("verify %-24s %-6s t of count values, max error %g, %s\n", "quatSoASlerpApprox", "tail", maxTailError, tailFailed ? "FAILED" : "ok");
+
+	free(exactT);
+	free(memory);
+
+	quatSoADestroy(&actual);
+	quatSoADestroy(&expected);
+	quatSoADestroy(&b);
+	quatSoADestroy(&a);
+
+	return failed;
+}
+
+// Every dual quaternion kernel against dualquatNlerp, on a count that leaves
+// a tail, and dualquatSoAToMat4SoA against dualquatToMat4
+int verifyDualQuatSoA()
+{
+	static const GLCSIMDLevel levels[] = { GLC_SIMD_SCALAR, GLC_SIMD_SSE2, GLC_SIMD_AVX };
+	static const size_t count = GLC_MAT4_SOA_WIDTH * 2 - 3;
+
+	GLCDualQuatSoA a, b, actual;
+	GLCMat4SoA matrices;
+
+	if (!dualquatSoACreate(&a, count) || !dualquatSoACreate(&b, count) || !dualquatSoACreate(&actual, count) || !mat4SoACreate(&matrices, count))
+	{
+		fprintf(stderr, "Failed allocating dual quaternions\n");
+		return 1;
+	}
+
+	float *t = (float*) malloc(a.capacity * sizeof(float));
+	float (*expected)[8] = (float(*)[8]) malloc(count * sizeof(float[8]));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float *r = rhsMatrices[i % matrixCount], *l = lhsMatrices[(i * 3) % matrixCount];
+		float q[4], da[8], db[8];
+
+		randomQuat(q, r);
+		dualquatFromQuatTranslation(da, q, r[4], r[5], r[6]);
+		dualquatSoASet(&a, i, da);
+
+		randomQuat(q, l);
+		dualquatFromQuatTranslation(db, q, l[4], l[5], l[6]);
+		dualquatSoASet(&b, i, db);
+
+		t[i] = (float) i / (float) count;
+
+		dualquatNlerp(expected[i], da, db, t[i]);
+	}
+
+	for (size_t i = count; i < a.capacity; ++i)
+		t[i] = 0.0f;
+
+	int failed = 0;
+
+	for (size_t l = 0; l < sizeof(levels) / sizeof(*levels); ++l)
+	{
+		const GLCDualQuatSoANlerpFunc nlerp = dualquatGetSoANlerpFunc(levels[l]);
+
+		if ((levels[l] != GLC_SIMD_SCALAR) && (nlerp == dualquatSoANlerpScalar))
+			continue;
+		if ((levels[l] == GLC_SIMD_AVX) && (linmathGetSIMDLevel() != GLC_SIMD_AVX))
+			continue;
+
+		nlerp(&actual, &a, &b, t, 0, a.capacity);
+
+		float maxError = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			float dq[8];
+			dualquatSoAGet(&actual, i, dq);
+
+			for (int c = 0; c < 8; ++c)
+				maxError = fmaxf(maxError, fabsf(expected[i][c] - dq[c]));
+		}
+
+		const int levelFailed = maxError > 1.0e-5f;
+		failed += levelFailed;
+
+		printf("verify %-24s %-6s max error %g, %s\n", "dualquatSoANlerp", linmathGetSIMDLevelString(levels[l]),
+		       maxError, levelFailed ? "FAILED" : "ok");
+	}
+
+	dualquatSoANlerp(&actual, &a, &b, t);
+	dualquatSoAToMat4SoA(&matrices, &actual);
+
+	float maxMatrixError = 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float dq[8], expectedMatrix[16], actualMatrix[16];
+
+		dualquatSoAGet(&actual, i, dq);
+		dualquatToMat4(expectedMatrix, dq);
+		mat4SoAGet(&matrices, i, actualMatrix);
+
+		maxMatrixError = fmaxf(maxMatrixError, maxDifference(expectedMatrix, actualMatrix));
+	}
+
+	const int matrixFailed = maxMatrixError > 1.0e-5f;
+	failed += matrixFailed;
+
+	printf("verify %-24s max error %g, %s\n", "dualquatSoAToMat4SoA", maxMatrixError, matrixFailed ? "FAILED" : "ok");
+
+	free(expected);
+	free(t);
+
+	mat4SoADestroy(&matrices);
+	dualquatSoADestroy(&actual);
+	dualquatSoADestroy(&b);
+	dualquatSoADestroy(&a);
+
+	return failed;
+}
+
+int benchmarkQuaternions()
+{
+	GLCQuatSoA a, b, result;
+	GLCMat4SoA matrices;
+
+	if (!quatSoACreate(&a, batchCount) || !quatSoACreate(&b, batchCount) || !quatSoACreate(&result, batchCount) || !mat4SoACreate(&matrices, batchCount))
+	{
+		fprintf(stderr, "Failed allocating quaternions\n");
+		return 1;
+	}
+
+	GLCDualQuatSoA dualA, dualB, dualResult;
+
+	if (!dualquatSoACreate(&dualA, batchCount) || !dualquatSoACreate(&dualB, batchCount) || !dualquatSoACreate(&dualResult, batchCount))
+	{
+		fprintf(stderr, "Failed allocating dual quaternions\n");
+		return 1;
+	}
+
+	float *t = (float*) malloc(batchCount * sizeof(float));
+
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		const float *r = rhsMatrices[i % matrixCount], *l = lhsMatrices[(i * 7) % matrixCount];
+		float q[4], dq[8];
+
+		randomQuat(q, r);
+		quatSoASet(&a, i, q);
+		dualquatFromQuatTranslation(dq, q, r[4], r[5], r[6]);
+		dualquatSoASet(&dualA, i, dq);
+
+		randomQuat(q, l);
+		quatSoASet(&b, i, q);
+		dualquatFromQuatTranslation(dq, q, l[4], l[5], l[6]);
+		dualquatSoASet(&dualB, i, dq);
+
+		t[i] = (float) i / (float) batchCount;
+	}
+
+	quatSoASlerpApprox(&result, &a, &b, t);
+
+	float maxSlerp = 0.0f;
+
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		float qa[4], qb[4], expected[4], actual[4];
+
+		quatSoAGet(&a, i, qa);
+		quatSoAGet(&b, i, qb);
+		quatSoAGet(&result, i, actual);
+
+		quatSlerp(expected, qa, qb, t[i]);
+		maxSlerp = fmaxf(maxSlerp, quatAngle(expected, actual));
+	}
+
+	const int failed = maxSlerp > 1.0e-3f;
+
+	printf("verify %-24s max angular error %g rad, %s\n", "quatSoASlerpApprox", maxSlerp, failed ? "FAILED" : "ok");
+
+	benchmark("mat4Rotation", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Rotation(resultMatrices[i], rhsMatrices[i][3], 0.0f, 1.0f, 0.0f);
+	});
+
+	benchmark("quatToMat4", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			quatToMat4(resultMatrices[i], rhsMatrices[i]);
+	});
+
+	benchmark("quatSlerp", batchIterations, batchCount, [&]()
+	{
+		float qa[4], qb[4], q[4];
+
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			quatSoAGet(&a, i, qa);
+			quatSoAGet(&b, i, qb);
+			quatSlerp(q, qa, qb, t[i]);
+			quatSoASet(&result, i, q);
+		}
+	});
+
+	benchmark("quatSoANlerp", batchIterations, batchCount, [&]()
+	{
+		quatSoANlerp(&result, &a, &b, t);
+	});
+
+	benchmark("quatSoASlerpApprox", batchIterations, batchCount, [&]()
+	{
+		quatSoASlerpApprox(&result, &a, &b, t);
+	});
+
+	benchmark("quatSoAToMat4SoA", batchIterations, batchCount, [&]()
+	{
+		quatSoAToMat4SoA(&matrices, &result);
+	});
+
+	benchmark("dualquatNlerp loop", batchIterations, batchCount, [&]()
+	{
+		float da[8], db[8], dq[8];
+
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			dualquatSoAGet(&dualA, i, da);
+			dualquatSoAGet(&dualB, i, db);
+			dualquatNlerp(dq, da, db, t[i]);
+			dualquatSoASet(&dualResult, i, dq);
+		}
+	});
+
+	benchmark("dualquatSoANlerp", batchIterations, batchCount, [&]()
+	{
+		dualquatSoANlerp(&dualResult, &dualA, &dualB, t);
+	});
+
+	benchmark("dualquatSoAToMat4SoA", batchIterations, batchCount, [&]()
+	{
+		dualquatSoAToMat4SoA(&matrices, &dualResult);
+	});
+
+	free(t);
+
+	dualquatSoADestroy(&dualResult);
+	dualquatSoADestroy(&dualB);
+	dualquatSoADestroy(&dualA);
+
+	mat4SoADestroy(&matrices);
+	quatSoADestroy(&result);
+	quatSoADestroy(&b);
+	quatSoADestroy(&a);
+
+	return failed;
+}
+
+int benchmarkCulling()
+{
+	static const size_t boundsCount = 100000;
+
+	float *bounds[6];
+	for (int i = 0; i < 6; ++i)
+		bounds[i] = (float*) malloc(boundsCount * sizeof(float));
+
+	uint32_t *visible = (uint32_t*) malloc(boundsCount * sizeof(uint32_t));
+	uint32_t *expected = (uint32_t*) malloc(boundsCount * sizeof(uint32_t));
+
+	for (size_t i = 0; i < boundsCount; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			bounds[j][i] = randomFloat(-50.0f, 50.0f);
+			bounds[3 + j][i] = randomFloat(0.0f, 2.0f);
+		}
+	}
+
+	float view[16];
+	mat4Identity(view);
+	mat4Rotate(view, GLC_RAD(30.0f), 0.0f, 1.0f, 0.0f);
+
+	GLCFrustum frustum;
+	frustumFromPerspectiveView(&frustum, 70.0f, 16.0f / 9.0f, 0.1f, 100.0f, view);
+
+	int failed = 0;
+
+	const size_t expectedSpheres = frustumCullSpheresScalar(&frustum, bounds, boundsCount, expected);
+	const size_t visibleSpheres = frustumCullSpheres(&frustum, bounds[0], bounds[1], bounds[2], bounds[3], boundsCount, visible);
+
+	failed += (expectedSpheres != visibleSpheres) || (memcmp(expected, visible, visibleSpheres * sizeof(uint32_t)) != 0);
+
+	const size_t expectedBoxes = frustumCullAABBsScalar(&frustum, bounds, boundsCount, expected);
+	const size_t visibleBoxes = frustumCullAABBs(&frustum, bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5], boundsCount, visible);
+
+	failed += (expectedBoxes != visibleBoxes) || (memcmp(expected, visible, visibleBoxes * sizeof(uint32_t)) != 0);
+
+	printf("verify %-24s %zu/%zu spheres, %zu/%zu boxes visible, %s\n",
+	       "frustum culling", visibleSpheres, boundsCount, visibleBoxes, boundsCount, failed ? "FAILED" : "ok");
+
+	benchmark("frustumCullSpheresScalar", batchIterations, boundsCount, [&]()
+	{
+		frustumCullSpheresScalar(&frustum, bounds, boundsCount, visible);
+	});
+
+	benchmark("frustumCullSpheres", batchIterations, boundsCount, [&]()
+	{
+		frustumCullSpheres(&frustum, bounds[0], bounds[1], bounds[2], bounds[3], boundsCount, visible);
+	});
+
+	benchmark("frustumCullAABBsScalar", batchIterations, boundsCount, [&]()
+	{
+		frustumCullAABBsScalar(&frustum, bounds, boundsCount, visible);
+	});
+
+	benchmark("frustumCullAABBs", batchIterations, boundsCount, [&]()
+	{
+		frustumCullAABBs(&frustum, bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5], boundsCount, visible);
+	});
+
+	free(expected);
+	free(visible);
+
+	for (int i = 0; i < 6; ++i)
+		free(bounds[i]);
+
+	return failed;
+}
+
+// Same layout as LoadOBJTriangleVertex
+typedef struct BenchVertex
+{
+	float x, y, z;
+	float u, v;
+	float nx, ny, nz;
+} BenchVertex;
+
+int benchmarkVertexTransforms()
+{
+	static const size_t vertexCount = 1000000;
+
+	BenchVertex *vertices = (BenchVertex*) malloc(vertexCount * sizeof(BenchVertex));
+	BenchVertex *transformed = (BenchVertex*) malloc(vertexCount * sizeof(BenchVertex));
+	BenchVertex *expected = (BenchVertex*) malloc(vertexCount * sizeof(BenchVertex));
+
+	float *positions[3], *results[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		positions[i] = (float*) malloc(vertexCount * sizeof(float));
+		results[i] = (float*) malloc(vertexCount * sizeof(float));
+	}
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		BenchVertex &vertex = vertices[i];
+
+		vertex.x = randomFloat(-1.0f, 1.0f);
+		vertex.y = randomFloat(-1.0f, 1.0f);
+		vertex.z = randomFloat(-1.0f, 1.0f);
+		vertex.u = vertex.v = 0.0f;
+		vertex.nx = vertex.ny = vertex.nz = 0.57735f;
+
+		positions[0][i] = vertex.x;
+		positions[1][i] = vertex.y;
+		positions[2][i] = vertex.z;
+	}
+
+	memcpy(transformed, vertices, vertexCount * sizeof(BenchVertex));
+	memcpy(expected, vertices, vertexCount * sizeof(BenchVertex));
+
+	float model[16];
+	randomRigidMatrix(model, rhsMatrices[0]);
+	mat4Scale(model, 1.0f, 2.0f, 0.5f);
+
+	const size_t stride = sizeof(BenchVertex);
+
+	mat4TransformAoSScalar(&expected[0].x, stride, model, &vertices[0].x, stride, vertexCount, 1.0f);
+	mat4TransformAoSScalar(&expected[0].nx, stride, model, &vertices[0].nx, stride, vertexCount, 0.0f);
+
+	mat4TransformPointsParallel(&transformed[0].x, stride, model, &vertices[0].x, stride, vertexCount);
+	mat4TransformDirections(&transformed[0].nx, stride, model, &vertices[0].nx, stride, vertexCount);
+
+	mat4TransformPointsSoA(results[0], results[1], results[2], model, positions[0], positions[1], positions[2], vertexCount);
+
+	int failed = memcmp(expected, transformed, vertexCount * sizeof(BenchVertex)) != 0;
+
+	for (size_t i = 0; i < vertexCount; ++i)
+		failed += (results[0][i] != expected[i].x) || (results[1][i] != expected[i].y) || (results[2][i] != expected[i].z);
+
+	printf("verify %-24s %s\n", "mat4TransformPoints", failed ? "FAILED" : "ok");
+
+	benchmark("mat4TransformAoSScalar", 10, vertexCount, [&]()
+	{
+		mat4TransformAoSScalar(&transformed[0].x, stride, model, &vertices[0].x, stride, vertexCount, 1.0f);
+	});
+
+	benchmark("mat4TransformPoints", 10, vertexCount, [&]()
+	{
+		mat4TransformPoints(&transformed[0].x, stride, model, &vertices[0].x, stride, vertexCount);
+	});
+
+	benchmark("mat4TransformPointsParallel", 10, vertexCount, [&]()
+	{
+		mat4TransformPointsParallel(&transformed[0].x, stride, model, &vertices[0].x, stride, vertexCount);
+	});
+
+	benchmark("mat4TransformPointsSoA", 10, vertexCount, [&]()
+	{
+		mat4TransformPointsSoA(results[0], results[1], results[2], model, positions[0], positions[1], positions[2], vertexCount);
+	});
+
+	benchmark("mat4TransformPointsSoAPar", 10, vertexCount, [&]()
+	{
+		mat4TransformPointsSoAParallel(results[0], results[1], results[2], model, positions[0], positions[1], positions[2], vertexCount);
+	});
+
+	for (int i = 0; i < 3; ++i)
+	{
+		free(results[i]);
+		free(positions[i]);
+	}
+
+	free(expected);
+	free(transformed);
+	free(vertices);
+
+	return failed;
+}
+
+int benchmarkSinCos()
+{
+	static const size_t angleCount = 65536;
+
+	float *angles = (float*) malloc(angleCount * sizeof(float));
+	float *sines = (float*) malloc(angleCount * sizeof(float));
+	float *cosines = (float*) malloc(angleCount * sizeof(float));
+
+	int failed = 0;
+
+	// The last range is mostly beyond GLC_SINCOS_MAX_ANGLE, checking the fallback
+	static const float ranges[] = { GLC_PI, 100.0f, GLC_SINCOS_MAX_ANGLE, 1.0e10f };
+
+	for (size_t r = 0; r < sizeof(ranges) / sizeof(*ranges); ++r)
+	{
+		for (size_t i = 0; i < angleCount; ++i)
+			angles[i] = randomFloat(-ranges[r], ranges[r]);
+
+		linmathSinCosBatch(angles, sines, cosines, angleCount);
+
+		float maxError = 0.0f, maxBatchDifference = 0.0f;
+
+		for (size_t i = 0; i < angleCount; ++i)
+		{
+			float s, c;
+			linmathSinCos(angles[i], &s, &c);
+
+			// Compared against double precision, as sinf/cosf have errors of their own
+			maxError = fmaxf(maxError, (float) fabs((double) s - sin((double) angles[i])));
+			maxError = fmaxf(maxError, (float) fabs((double) c - cos((double) angles[i])));
+
+			maxBatchDifference = fmaxf(maxBatchDifference, fabsf(s - sines[i]));
+			maxBatchDifference = fmaxf(maxBatchDifference, fabsf(c - cosines[i]));
+		}
+
+		const int rangeFailed = (maxError > 2.0e-7f) || (maxBatchDifference > 0.0f);
+		failed += rangeFailed;
+
+		printf("verify %-24s |angle| <= %g, max error %g, batch difference %g, %s\n",
+		       "linmathSinCos", ranges[r], maxError, maxBatchDifference, rangeFailed ? "FAILED" : "ok");
+	}
+
+	// Typical animation angles, libm is a lot slower for large angles
+	for (size_t i = 0; i < angleCount; ++i)
+		angles[i] = randomFloat(-2.0f * GLC_PI, 2.0f * GLC_PI);
+
+	benchmark("sinf cosf", batchIterations, angleCount, [=]()
+	{
+		for (size_t i = 0; i < angleCount; ++i)
+		{
+			sines[i] = sinf(angles[i]);
+			cosines[i] = cosf(angles[i]);
+		}
+	});
+
+	benchmark("linmathSinCos", batchIterations, angleCount, [=]()
+	{
+		for (size_t i = 0; i < angleCount; ++i)
+			linmathSinCos(angles[i], sines + i, cosines + i);
+	});
+
+	benchmark("linmathSinCosBatch", batchIterations, angleCount, [=]()
+	{
+		linmathSinCosBatch(angles, sines, cosines, angleCount);
+	});
+
+	benchmark("mat4Rotation loop", iterations, matrixCount, [=]()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Rotation(resultMatrices[i], angles[i], 0.0f, 1.0f, 0.0f);
+	});
+
+	benchmark("mat4RotationSinCos batch", iterations, matrixCount, [=]()
+	{
+		linmathSinCosBatch(angles, sines, cosines, matrixCount);
+
+		for (int i = 0; i < matrixCount; ++i)
+			mat4RotationSinCos(resultMatrices[i], sines[i], cosines[i], 0.0f, 1.0f, 0.0f);
+	});
+
+	free(cosines);
+	free(sines);
+	free(angles);
+
+	return failed;
+}
+
+// Recomputes every world matrix from scratch
+void transformHierarchyReference(float (*world)[16], const GLCTransformHierarchy *hierarchy)
+{
+	for (size_t i = 0; i < hierarchy->count; ++i)
+	{
+		const int32_t parent = hierarchy->parents[i];
+
+		if (parent == GLC_TRANSFORM_NO_PARENT)
+			memcpy(world[i], hierarchy->local[i], sizeof(world[i]));
+		else
+			mat4MultiplyScalar(world[i], world[parent], hierarchy->local[i]);
+	}
+}
+
+int benchmarkHierarchy()
+{
+	static const size_t rootCount = 1024;
+	static const size_t subtreeSize = 64;
+	static const size_t nodeCount = rootCount * subtreeSize;
+
+	GLCTransformHierarchy hierarchy;
+
+	// Starts small to exercise growing
+	if (!transformHierarchyCreate(&hierarchy, 16))
+	{
+		printf("verify %-24s allocation FAILED\n", "transformHierarchy");
+		return 1;
+	}
+
+	float (*reference)[16] = (float(*)[16]) malloc(nodeCount * sizeof(*reference));
+
+	float local[16];
+
+	for (size_t r = 0; r < rootCount; ++r)
+	{
+		mat4Translation(local, randomFloat(-100.0f, 100.0f), 0.0f, randomFloat(-100.0f, 100.0f));
+		const int32_t root = transformHierarchyAdd(&hierarchy, GLC_TRANSFORM_NO_PARENT, local);
+
+		// Random parents within the subtree, always added before their children
+		for (size_t i = 1; i < subtreeSize; ++i)
+		{
+			mat4Rotation(local, randomFloat(-GLC_PI, GLC_PI), 0.0f, 1.0f, 0.0f);
+			mat4Translate(local, randomFloat(-1.0f, 1.0f), randomFloat(0.0f, 1.0f), randomFloat(-1.0f, 1.0f));
+
+			transformHierarchyAdd(&hierarchy, root + (int32_t) (rand() % i), local);
+		}
+	}
+
+	int failed = 0;
+
+	const size_t firstUpdated = transformHierarchyUpdate(&hierarchy);
+
+	// Dirty a few nodes, alternating between the serial and parallel paths
+	size_t expectedUpdated = 0;
+	float maxError = 0.0f;
+
+	for (int n = 0; n < 4; ++n)
+	{
+		for (int i = 0; i < 64; ++i)
+		{
+			const int32_t index = (int32_t) (rand() % nodeCount);
+			mat4Rotate(transformHierarchyEditLocal(&hierarchy, index), 0.1f, 1.0f, 0.0f, 0.0f);
+		}
+
+		if (n & 1)
+			transformHierarchyUpdateParallel(&hierarchy);
+		else
+			transformHierarchyUpdate(&hierarchy);
+
+		transformHierarchyReference(reference, &hierarchy);
+
+		for (size_t i = 0; i < nodeCount; ++i)
+			maxError = fmaxf(maxError, maxDifference(hierarchy.world[i], reference[i]));
+	}
+
+	// Dirtying a root updates exactly its subtree
+	transformHierarchyEditLocal(&hierarchy, (int32_t) subtreeSize);
+	expectedUpdated = transformHierarchyUpdate(&hierarchy);
+
+	const int hierarchyFailed = (firstUpdated != nodeCount) || (hierarchy.segmentCount != rootCount) ||
+	                            (expectedUpdated != subtreeSize) || (maxError > 1.0e-3f);
+	failed += hierarchyFailed;
+
+	printf("verify %-24s %zu segments, subtree update %zu, max error %g, %s\n",
+	       "transformHierarchy", hierarchy.segmentCount, expectedUpdated, maxError, hierarchyFailed ? "FAILED" : "ok");
+
+	benchmark("hierarchy reference", batchIterations, nodeCount, [&]()
+	{
+		transformHierarchyReference(reference, &hierarchy);
+	});
+
+	benchmark("hierarchy full", batchIterations, nodeCount, [&]()
+	{
+		memset(hierarchy.dirty, 1, nodeCount);
+		transformHierarchyUpdate(&hierarchy);
+	});
+
+	benchmark("hierarchy full parallel", batchIterations, nodeCount, [&]()
+	{
+		memset(hierarchy.dirty, 1, nodeCount);
+		transformHierarchyUpdateParallel(&hierarchy);
+	});
+
+	// Roughly 1% of nodes animated per frame, measured per node in the hierarchy
+	int32_t animated[nodeCount / 100];
+
+	for (size_t i = 0; i < sizeof(animated) / sizeof(*animated); ++i)
+		animated[i] = (int32_t) (rand() % nodeCount);
+
+	benchmark("hierarchy 1% dirty", batchIterations, nodeCount, [&]()
+	{
+		for (size_t i = 0; i < sizeof(animated) / sizeof(*animated); ++i)
+			transformHierarchyEditLocal(&hierarchy, animated[i]);
+
+		transformHierarchyUpdate(&hierarchy);
+	});
+
+	benchmark("hierarchy 1% dirty par", batchIterations, nodeCount, [&]()
+	{
+		for (size_t i = 0; i < sizeof(animated) / sizeof(*animated); ++i)
+			transformHierarchyEditLocal(&hierarchy, animated[i]);
+
+		transformHierarchyUpdateParallel(&hierarchy);
+	});
+
+	free(reference);
+	transformHierarchyDestroy(&hierarchy);
+
+	return failed;
+}
+
+// Single calls of the remaining builders and quaternion functions, such
+// that every public function has a number to compare between runs
+void benchmarkSingle()
+{
+	static float quats[matrixCount][4], quatResults[matrixCount][4];
+	static float dualquats[matrixCount][8], dualquatResults[matrixCount][8];
+
+	for (int i = 0; i < matrixCount; ++i)
+	{
+		randomQuat(quats[i], rhsMatrices[i]);
+		dualquatFromQuatTranslation(dualquats[i], quats[i], lhsMatrices[i][0], lhsMatrices[i][1], lhsMatrices[i][2]);
+	}
+
+	benchmark("mat4Identity", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Identity(resultMatrices[i]);
+	});
+
+	benchmark("mat4Translation", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Translation(resultMatrices[i], rhsMatrices[i][0], rhsMatrices[i][1], rhsMatrices[i][2]);
+	});
+
+	benchmark("mat4Scaling", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Scaling(resultMatrices[i], rhsMatrices[i][0], rhsMatrices[i][1], rhsMatrices[i][2]);
+	});
+
+	benchmark("mat4Perspective", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4Perspective(resultMatrices[i], 60.0f + rhsMatrices[i][0], 4.0f / 3.0f, 0.01f, 10.0f);
+	});
+
+	benchmark("mat4PerspectiveMultiply", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			mat4PerspectiveMultiply(resultMatrices[i], 70.0f, 4.0f / 3.0f, 0.01f, 10.0f, rhsMatrices[i]);
+	});
+
+	benchmark("mat4TransformDirections", iterations, matrixCount / 4, []()
+	{
+		mat4TransformDirections(resultMatrices[0], 4 * sizeof(float), lhsMatrices[0], rhsMatrices[0], 4 * sizeof(float), matrixCount / 4);
+	});
+
+	benchmark("quatRotation", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			quatRotation(quatResults[i], rhsMatrices[i][3], 0.0f, 1.0f, 0.0f);
+	});
+
+	benchmark("quatMultiply", iterations, matrixCount - 1, []()
+	{
+		for (int i = 0; i < (matrixCount - 1); ++i)
+			quatMultiply(quatResults[i], quats[i], quats[i + 1]);
+	});
+
+	benchmark("quatNormalize", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			quatNormalize(quats[i]);
+	});
+
+	benchmark("quatFromMat4", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			quatFromMat4(quatResults[i], rhsMatrices[i]);
+	});
+
+	benchmark("quatNlerp", iterations, matrixCount - 1, []()
+	{
+		for (int i = 0; i < (matrixCount - 1); ++i)
+			quatNlerp(quatResults[i], quats[i], quats[i + 1], 0.25f);
+	});
+
+	benchmark("dualquatMultiply", iterations, matrixCount - 1, []()
+	{
+		for (int i = 0; i < (matrixCount - 1); ++i)
+			dualquatMultiply(dualquatResults[i], dualquats[i], dualquats[i + 1]);
+	});
+
+	benchmark("dualquatNlerp", iterations, matrixCount - 1, []()
+	{
+		for (int i = 0; i < (matrixCount - 1); ++i)
+			dualquatNlerp(dualquatResults[i], dualquats[i], dualquats[i + 1], 0.25f);
+	});
+
+	benchmark("dualquatToMat4", iterations, matrixCount, []()
+	{
+		for (int i = 0; i < matrixCount; ++i)
+			dualquatToMat4(resultMatrices[i], dualquats[i]);
+	});
+}
+
+void printUsage(const char *program)
+{
+	printf("usage: %s [--json results.json]\n", program);
+	printf("       %s --compare baseline.json current.json [threshold percent]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *jsonPath = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--json") == 0) && ((i + 1) < argc))
+		{
+			jsonPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--compare") == 0) && ((i + 2) < argc))
+		{
+			const double threshold = ((i + 3) < argc) ? atof(argv[i + 3]) : 5.0;
+			return compareBenchResults(argv[i + 1], argv[i + 2], threshold) ? EXIT_FAILURE : EXIT_SUCCESS;
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	randomMatrices();
+
+	const GLCSIMDLevel level = linmathGetSIMDLevel();
+	printf("SIMD level: %s\n", linmathGetSIMDLevelString(level));
+
+	static const GLCSIMDLevel levels[] = {
+			GLC_SIMD_SCALAR, GLC_SIMD_SSE2, GLC_SIMD_AVX, GLC_SIMD_NEON,
+	};
+
+	int failed = 0;
+
+	for (size_t i = 0; i < sizeof(levels) / sizeof(*levels); ++i)
+	{
+		const GLCMat4MultiplyFunc multiply = mat4GetMultiplyFunc(levels[i]);
+
+		// Skip levels that are not compiled in, or not supported by this CPU
+		if ((levels[i] != GLC_SIMD_SCALAR) && (multiply == mat4MultiplyScalar))
+			continue;
+		if ((levels[i] == GLC_SIMD_AVX) && (level != GLC_SIMD_AVX))
+			continue;
+
+		failed += verifyMultiply(linmathGetSIMDLevelString(levels[i]), multiply, 1.0e-3f);
+	}
+
+	for (size_t i = 0; i < sizeof(levels) / sizeof(*levels); ++i)
+	{
+		const GLCMat4MultiplyFunc multiply = mat4GetMultiplyFunc(levels[i]);
+
+		if ((levels[i] != GLC_SIMD_SCALAR) && (multiply == mat4MultiplyScalar))
+			continue;
+		if ((levels[i] == GLC_SIMD_AVX) && (level != GLC_SIMD_AVX))
+			continue;
+
+		benchmarkMultiply(linmathGetSIMDLevelString(levels[i]), multiply);
+	}
+
+	benchmarkMultiply("dispatch", mat4Multiply);
+
+	failed += benchmarkBatch();
+
+	failed += verifyTransforms();
+	benchmarkTransforms();
+
+	failed += verifyInverse();
+	benchmarkInverse();
+
+	failed += verifyQuaternions();
+	failed += verifyQuatSoAKernels();
+	failed += verifyDualQuatSoA();
+	failed += benchmarkQuaternions();
+
+	failed += benchmarkCulling();
+
+	failed += benchmarkVertexTransforms();
+
+	failed += benchmarkSinCos();
+
+	failed += benchmarkHierarchy();
+
+	benchmarkSingle();
+
+	if (jsonPath && !writeBenchResults(jsonPath))
+		++failed;
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#ifndef GLC_MESH_H
+#define GLC_MESH_H
+
+#include "gl.h"
+
+#define GLC_CUBE_VERTEX_SIZE 6
+
+// Unit cube centered at the origin, as triangles with outward normals
+static const GLfloat glcCubeVertices[] = {
+	// X, Y, Z, NX, NY, NZ
+
+	// Front
+	-0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Left
+	-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Left
+	 0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Right
+
+	 0.5f,  0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Top Right
+	-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Left
+	 0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, // Bottom Right
+
+	// Back
+	 0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Left
+	 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Left
+	-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Right
+
+	-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Top Right
+	 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Left
+	-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, // Bottom Right
+
+	// Top
+	-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Left
+	-0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Left
+	 0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Right
+
+	 0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, // Top Right
+	-0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Left
+	 0.5f, 0.5f,  0.5f, 0.0f, 1.0f, 0.0f, // Bottom Right
+
+	 // Bottom
+	-0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Left
+	-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Left
+	 0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Right
+
+	 0.5f, -0.5f,  0.5f, 0.0f, -1.0f, 0.0f, // Top Right
+	-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Left
+	 0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, // Bottom Right
+
+	// Right
+	0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Top Left
+	0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Bottom Left
+	0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Top Right
+
+	0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Top Right
+	0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f, // Bottom Left
+	0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, // Bottom Right
+
+	// Left
+	-0.5f,  0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Top Left
+	-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Bottom Left
+	-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Top Right
+
+	-0.5f,  0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Top Right
+	-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, // Bottom Left
+	-0.5f, -0.5f,  0.5f, -1.0f, 0.0f, 0.0f, // Bottom Right
+};
+
+static const GLsizei glcCubeVertexCount = sizeof(glcCubeVertices) / sizeof(*glcCubeVertices) / GLC_CUBE_VERTEX_SIZE;
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef GLC_MESH_BUFFER_H
+#define GLC_MESH_BUFFER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "gl_state.h"
+#include "stream_buffer.h"
+
+// The layout glMultiDrawElementsIndirect reads
+typedef struct GLCDrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+} GLCDrawElementsIndirectCommand;
+
+// Where a mesh lives in the shared buffers. Its indices are relative to
+// its first vertex
+typedef struct GLCMeshRange
+{
+	GLuint firstIndex, indexCount;
+	GLint baseVertex;
+	GLuint vertexCount;
+} GLCMeshRange;
+
+// Many meshes packed into one vertex buffer and one index buffer, drawn
+// through a single vertex array. The capacities are fixed when created
+typedef struct GLCMeshBuffer
+{
+	GLuint vertexArray, vertexBuffer, indexBuffer;
+
+	// Bytes per vertex
+	GLsizei vertexSize;
+
+	GLuint vertexCount, vertexCapacity;
+	GLuint indexCount, indexCapacity;
+
+	GLCMeshRange *meshes;
+	size_t meshCount, meshCapacity;
+
+	// The per-draw attribute selected by baseInstance, -1 if none
+	GLint instanceLocation;
+	GLint instanceColumns;
+	GLuint instanceBuffer;
+} GLCMeshBuffer;
+
+// Returns 0 on failure
+int glcMeshBufferCreate(GLCMeshBuffer *buffer, GLCStateCache *state, GLsizei vertexSize, GLuint vertexCapacity, GLuint indexCapacity)
+{
+	memset(buffer, 0, sizeof(GLCMeshBuffer));
+
+	buffer->vertexSize = vertexSize;
+	buffer->vertexCapacity = vertexCapacity;
+	buffer->indexCapacity = indexCapacity;
+	buffer->instanceLocation = -1;
+
+	glGenVertexArrays(1, &buffer->vertexArray);
+	glGenBuffers(1, &buffer->vertexBuffer);
+	glGenBuffers(1, &buffer->indexBuffer);
+
+	if ((buffer->vertexArray == GLC_NULL_HANDLE) || (buffer->vertexBuffer == GLC_NULL_HANDLE) || (buffer->indexBuffer == GLC_NULL_HANDLE))
+		return 0;
+
+	glcStateBindVertexArray(state, buffer->vertexArray);
+
+	glcStateBindBuffer(state, GL_ARRAY_BUFFER, buffer->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) vertexSize * vertexCapacity, NULL, GL_STATIC_DRAW);
+
+	// Recorded in the vertex array
+	glcStateBindBuffer(state, GL_ELEMENT_ARRAY_BUFFER, buffer->indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) sizeof(GLuint) * indexCapacity, NULL, GL_STATIC_DRAW);
+
+	return 1;
+}
+
+void glcMeshBufferDestroy(GLCMeshBuffer *buffer, GLCStateCache *state)
+{
+	glcStateDeleteVertexArrays(state, 1, &buffer->vertexArray);
+	glcStateDeleteBuffers(state, 1, &buffer->vertexBuffer);
+	glcStateDeleteBuffers(state, 1, &buffer->indexBuffer);
+
+	free(buffer->meshes);
+
+	memset(buffer, 0, sizeof(GLCMeshBuffer));
+}
+
+// A float attribute in the shared vertex buffer, offset in bytes
+void glcMeshBufferAttribute(GLCMeshBuffer *buffer, GLCStateCache *state, GLuint location, GLint size, GLsizeiptr offset)
+{
+	glcStateBindVertexArray(state, buffer->vertexArray);
+	glcStateBindBuffer(state, GL_ARRAY_BUFFER, buffer->vertexBuffer);
+
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, buffer->vertexSize, (const GLvoid*) offset);
+}
+
+// A per-draw attribute of columns vec4s, like a mat4, advancing once per
+// instance. Draws select their element with baseInstance
+void glcMeshBufferInstanceAttribute(GLCMeshBuffer *buffer, GLCStateCache *state, GLuint location, GLuint instanceBuffer, GLint columns)
+{
+	buffer->instanceLocation = (GLint) location;
+	buffer->instanceColumns = columns;
+	buffer->instanceBuffer = instanceBuffer;
+
+	glcStateBindVertexArray(state, buffer->vertexArray);
+	glcStateBindBuffer(state, GL_ARRAY_BUFFER, instanceBuffer);
+
+	for (GLint column = 0; column < columns; ++column)
+	{
+		glEnableVertexAttribArray(location + (GLuint) column);
+		glVertexAttribPointer(location + (GLuint) column, 4, GL_FLOAT, GL_FALSE, columns * 4 * sizeof(GLfloat), (const GLvoid*) (column * 4 * sizeof(GLfloat)));
+		glVertexAttribDivisor(location + (GLuint) column, 1);
+	}
+}
+
+// Points the per-draw attribute at element
+void glcMeshBufferSetInstanceOffset(const GLCMeshBuffer *buffer, GLuint element)
+{
+	const GLsizei stride = buffer->instanceColumns * 4 * sizeof(GLfloat);
+
+	for (GLint column = 0; column < buffer->instanceColumns; ++column)
+	{
+		const GLsizeiptr offset = (GLsizeiptr) stride * element + column * 4 * sizeof(GLfloat);
+		glVertexAttribPointer((GLuint) (buffer->instanceLocation + column), 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*) offset);
+	}
+}
+
+// Copies a mesh into the shared buffers. indices may be NULL for meshes
+// drawn as plain triangles, which then get sequential ones. Returns the
+// mesh, or -1 if it is empty or does not fit
+int glcMeshBufferAdd(GLCMeshBuffer *buffer, GLCStateCache *state, const GLvoid *vertices, GLuint vertexCount, const GLuint *indices, GLuint indexCount)
+{
+	if (!indices)
+		indexCount = vertexCount;
+
+	if (!vertexCount || !indexCount)
+		return -1;
+
+	if (((buffer->vertexCapacity - buffer->vertexCount) < vertexCount) || ((buffer->indexCapacity - buffer->indexCount) < indexCount))
+		return -1;
+
+	if (buffer->meshCount == buffer->meshCapacity)
+	{
+		const size_t capacity = buffer->meshCapacity ? (buffer->meshCapacity * 2) : 64;
+		GLCMeshRange *meshes = (GLCMeshRange*) realloc(buffer->meshes, capacity * sizeof(GLCMeshRange));
+
+		if (!meshes)
+			return -1;
+
+		buffer->meshes = meshes;
+		buffer->meshCapacity = capacity;
+	}
+
+	GLuint *sequential = NULL;
+
+	if (!indices)
+	{
+		sequential = (GLuint*) malloc(indexCount * sizeof(GLuint));
+
+		if (!sequential)
+			return -1;
+
+		for (GLuint i = 0; i < indexCount; ++i)
+			sequential[i] = i;
+
+		indices = sequential;
+	}
+
+	glcStateBindBuffer(state, GL_ARRAY_BUFFER, buffer->vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) buffer->vertexSize * buffer->vertexCount, (GLsizeiptr) buffer->vertexSize * vertexCount, vertices);
+
+	// The index buffer is only bound through the vertex array
+	glcStateBindVertexArray(state, buffer->vertexArray);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr) sizeof(GLuint) * buffer->indexCount, (GLsizeiptr) sizeof(GLuint) * indexCount, indices);
+
+	free(sequential);
+
+	GLCMeshRange *mesh = buffer->meshes + buffer->meshCount;
+
+	mesh->firstIndex = buffer->indexCount;
+	mesh->indexCount = indexCount;
+	mesh->baseVertex = (GLint) buffer->vertexCount;
+	mesh->vertexCount = vertexCount;
+
+	buffer->vertexCount += vertexCount;
+	buffer->indexCount += indexCount;
+
+	return (int) buffer->meshCount++;
+}
+
+typedef enum GLCMultiDrawPath
+{
+	// A single glMultiDrawElementsIndirect for every draw
+	GLC_MULTI_DRAW_INDIRECT,
+
+	// A glDrawElementsInstancedBaseVertexBaseInstance per draw
+	GLC_MULTI_DRAW_BASE_INSTANCE,
+
+	// A glDrawElementsInstancedBaseVertex per draw, moving the per-draw
+	// attribute to emulate baseInstance
+	GLC_MULTI_DRAW_LOOP
+} GLCMultiDrawPath;
+
+typedef struct GLCMultiDrawStats
+{
+	// Draws submitted, and the GL calls they took
+	unsigned int draws, calls;
+} GLCMultiDrawStats;
+
+typedef struct GLCMultiDraw
+{
+	GLCMultiDrawPath path;
+
+	GLCDrawElementsIndirectCommand *commands;
+	size_t count, capacity;
+
+	// The commands uploaded for the indirect path
+	GLCStreamBuffer stream;
+
+	GLCMultiDrawStats stats;
+} GLCMultiDraw;
+
+const char* glcGetMultiDrawPathString(GLCMultiDrawPath path)
+{
+	switch (path)
+	{
+	case GLC_MULTI_DRAW_INDIRECT:
+		return "MultiDrawIndirect";
+	case GLC_MULTI_DRAW_BASE_INSTANCE:
+		return "BaseInstance";
+	case GLC_MULTI_DRAW_LOOP:
+		return "Loop";
+	default:
+		return "Unknown";
+	}
+}
+
+int glcIsMultiDrawPathSupported(GLCMultiDrawPath path)
+{
+	switch (path)
+	{
+	case GLC_MULTI_DRAW_INDIRECT:
+		return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_multi_draw_indirect;
+	case GLC_MULTI_DRAW_BASE_INSTANCE:
+		return GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_base_instance;
+	case GLC_MULTI_DRAW_LOOP:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Uses the given path if supported, otherwise the best one that is below
+// it. capacity is the most draws submitted in a frame. Returns 0 on failure
+int glcMultiDrawCreate(GLCMultiDraw *draw, GLCStateCache *state, size_t capacity, GLCMultiDrawPath path = GLC_MULTI_DRAW_INDIRECT)
+{
+	memset(draw, 0, sizeof(GLCMultiDraw));
+
+	if (!capacity)
+		return 0;
+
+	while (!glcIsMultiDrawPathSupported(path))
+		path = (GLCMultiDrawPath) (path + 1);
+
+	if (path == GLC_MULTI_DRAW_INDIRECT)
+	{
+		if (!glcStreamBufferCreate(&draw->stream, state, GL_DRAW_INDIRECT_BUFFER, capacity * sizeof(GLCDrawElementsIndirectCommand)))
+			path = GLC_MULTI_DRAW_BASE_INSTANCE;
+
+		if (!glcIsMultiDrawPathSupported(path))
+			path = GLC_MULTI_DRAW_LOOP;
+	}
+
+	draw->path = path;
+
+	draw->commands = (GLCDrawElementsIndirectCommand*) malloc(capacity * sizeof(GLCDrawElementsIndirectCommand));
+	draw->capacity = capacity;
+
+	return draw->commands != NULL;
+}
+
+void glcMultiDrawDestroy(GLCMultiDraw *draw, GLCStateCache *state)
+{
+	if (draw->stream.buffer != GLC_NULL_HANDLE)
+		glcStreamBufferDestroy(&draw->stream, state);
+
+	free(draw->commands);
+
+	memset(draw, 0, sizeof(GLCMultiDraw));
+}
+
+// Must be called once per frame, before the first submit
+void glcMultiDrawBeginFrame(GLCMultiDraw *draw, GLCStateCache *state)
+{
+	draw->count = 0;
+	memset(&draw->stats, 0, sizeof(GLCMultiDrawStats));
+
+	if (draw->path == GLC_MULTI_DRAW_INDIRECT)
+		glcStreamBufferBeginFrame(&draw->stream, state);
+}
+
+// Must be called once per frame, after the last submit
+void glcMultiDrawEndFrame(GLCMultiDraw *draw, GLCStateCache *state)
+{
+	if (draw->path == GLC_MULTI_DRAW_INDIRECT)
+		glcStreamBufferEndFrame(&draw->stream, state);
+}
+
+void glcMultiDrawReset(GLCMultiDraw *draw)
+{
+	draw->count = 0;
+}
+
+// baseInstance selects the per-draw attribute element. Returns 0 if the
+// draw is full
+int glcMultiDrawPush(GLCMultiDraw *draw, const GLCMeshBuffer *buffer, int mesh, GLuint instanceCount = 1, GLuint baseInstance = 0)
+{
+	if ((draw->count == draw->capacity) || (mesh < 0) || ((size_t) mesh >= buffer->meshCount))
+		return 0;
+
+	const GLCMeshRange *range = buffer->meshes + mesh;
+	GLCDrawElementsIndirectCommand *command = draw->commands + draw->count++;
+
+	command->count = range->indexCount;
+	command->instanceCount = instanceCount;
+	command->firstIndex = range->firstIndex;
+	command->baseVertex = range->baseVertex;
+	command->baseInstance = baseInstance;
+
+	return 1;
+}
+
+// Draws everything pushed since the last reset, with the program in use.
+// Can be called several times per frame, the indirect path takes the
+// commands from the frame's stream buffer region
+void glcMultiDrawSubmit(GLCMultiDraw *draw, const GLCMeshBuffer *buffer, GLCStateCache *state, GLenum mode = GL_TRIANGLES)
+{
+	draw->stats.draws += (unsigned int) draw->count;
+
+	if (!draw->count)
+		return;
+
+	glcStateBindVertexArray(state, buffer->vertexArray);
+
+	if (draw->path == GLC_MULTI_DRAW_INDIRECT)
+	{
+		GLintptr offset;
+		void *commands = glcStreamBufferAlloc(&draw->stream, state, draw->count * sizeof(GLCDrawElementsIndirectCommand), &offset);
+
+		if (!commands)
+			return;
+
+		memcpy(commands, draw->commands, draw->count * sizeof(GLCDrawElementsIndirectCommand));
+
+		glcStreamBufferFlush(&draw->stream, state);
+
+		glcStateBindBuffer(state, GL_DRAW_INDIRECT_BUFFER, draw->stream.buffer);
+
+		glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (const GLvoid*) offset, (GLsizei) draw->count, 0);
+		++draw->stats.calls;
+	}
+	else if (draw->path == GLC_MULTI_DRAW_BASE_INSTANCE)
+	{
+		for (size_t i = 0; i < draw->count; ++i)
+		{
+			const GLCDrawElementsIndirectCommand *command = draw->commands + i;
+
+			glDrawElementsInstancedBaseVertexBaseInstance(mode, (GLsizei) command->count, GL_UNSIGNED_INT,
+			                                              (const GLvoid*) (command->firstIndex * sizeof(GLuint)),
+			                                              (GLsizei) command->instanceCount, command->baseVertex, command->baseInstance);
+		}
+
+		draw->stats.calls += (unsigned int) draw->count;
+	}
+	else
+	{
+		const int emulateBaseInstance = buffer->instanceLocation != -1;
+		GLuint baseInstance = 0;
+
+		if (emulateBaseInstance)
+			glcStateBindBuffer(state, GL_ARRAY_BUFFER, buffer->instanceBuffer);
+
+		for (size_t i = 0; i < draw->count; ++i)
+		{
+			const GLCDrawElementsIndirectCommand *command = draw->commands + i;
+
+			if (emulateBaseInstance && (command->baseInstance != baseInstance))
+			{
+				baseInstance = command->baseInstance;
+				glcMeshBufferSetInstanceOffset(buffer, baseInstance);
+			}
+
+			glDrawElementsInstancedBaseVertex(mode, (GLsizei) command->count, GL_UNSIGNED_INT,
+			                                  (const GLvoid*) (command->firstIndex * sizeof(GLuint)),
+			                                  (GLsizei) command->instanceCount, command->baseVertex);
+		}
+
+		draw->stats.calls += (unsigned int) draw->count;
+
+		// Leaves the vertex array as it was set up
+		if (baseInstance)
+			glcMeshBufferSetInstanceOffset(buffer, 0);
+	}
+}
+
+void glcMultiDrawPrintStats(const GLCMultiDraw *draw)
+{
+	printf("Multi Draw: %s, %u draws in %u calls\n", glcGetMultiDrawPathString(draw->path), draw->stats.draws, draw->stats.calls);
+}
+
+#endif
@@ -0,0 +1,394 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "gl_state.h"
+#include "shader.h"
+#include "program_cache.h"
+#include "shader_reflection.h"
+#include "mesh.h"
+#include "mesh_buffer.h"
+#include "linmath.h"
+#include "glfw_utilities.h"
+
+// Spreads i over [0, 1]
+static float hashUnit(unsigned int i)
+{
+	i *= 2654435761u;
+	i ^= i >> 16;
+
+	return (float) (i & 0xFFFF) / 65535.0f;
+}
+
+int main(int argc, char *argv[])
+{
+	if (!glfwInit())
+	{
+		fprintf(stderr, "Failed initializing GLFW\n");
+		return EXIT_FAILURE;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+	GLFWwindow *window = glfwCreateWindow(640, 480, "Multi Draw - GLCollection", NULL, NULL);
+
+	if (!window)
+	{
+		fprintf(stderr, "Failed creating window\n");
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+
+	glcCenterWindow(window, glcGetBestMonitor(window));
+
+	glfwShowWindow(window);
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		fprintf(stderr, "Failed loading OpenGL functions and extensions\n");
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+
+	// The model matrix is a per-draw attribute, selected by baseInstance
+	static const GLchar *vertexShaderSource =
+			"#version 330 core\n"
+			"\n"
+			"out vec3 vNormal;\n"
+			"\n"
+			"in vec3 position;\n"
+			"in vec3 normal;\n"
+			"in mat4 model;\n"
+			"\n"
+			"uniform mat4 viewProjection;\n"
+			"\n"
+			"void main()\n"
+			"{\n"
+			"    vNormal = normal;\n"
+			"    gl_Position = viewProjection * model * vec4(position, 1.0);\n"
+			"}\n";
+
+	// What every example did before, a vertex array per mesh and a uniform per draw
+	static const GLchar *perMeshVertexShaderSource =
+			"#version 330 core\n"
+			"\n"
+			"out vec3 vNormal;\n"
+			"\n"
+			"in vec3 position;\n"
+			"in vec3 normal;\n"
+			"\n"
+			"uniform mat4 model;\n"
+			"uniform mat4 viewProjection;\n"
+			"\n"
+			"void main()\n"
+			"{\n"
+			"    vNormal = normal;\n"
+			"    gl_Position = viewProjection * model * vec4(position, 1.0);\n"
+			"}\n";
+
+	static const GLchar *fragmentShaderSource =
+			"#version 330 core\n"
+			"\n"
+			"out vec4 fragColor;\n"
+			"\n"
+			"in vec3 vNormal;\n"
+			"\n"
+			"void main()\n"
+			"{\n"
+			"    fragColor = vec4(abs(vNormal), 1.0);\n"
+			"}\n";
+
+	// multi_draw [count] [--base-instance|--loop|--per-mesh], space cycles
+	// through the paths, starting from the best one supported
+	int meshCount = 4096;
+	int path = GLC_MULTI_DRAW_INDIRECT;
+
+	// After the mesh buffer paths
+	static const int perMeshPath = GLC_MULTI_DRAW_LOOP + 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--base-instance") == 0)
+			path = GLC_MULTI_DRAW_BASE_INSTANCE;
+		else if (strcmp(argv[i], "--loop") == 0)
+			path = GLC_MULTI_DRAW_LOOP;
+		else if (strcmp(argv[i], "--per-mesh") == 0)
+			path = perMeshPath;
+		else if (atoi(argv[i]) > 0)
+			meshCount = atoi(argv[i]);
+	}
+
+	GLCProgramCache programCache;
+	glcProgramCacheInit(&programCache);
+
+	const GLuint program = glcProgramCacheCreateProgram(&programCache, vertexShaderSource, fragmentShaderSource);
+	const GLuint perMeshProgram = glcProgramCacheCreateProgram(&programCache, perMeshVertexShaderSource, fragmentShaderSource);
+
+	if ((program == GLC_NULL_HANDLE) || (perMeshProgram == GLC_NULL_HANDLE))
+		return EXIT_FAILURE;
+
+	glcProgramCachePrintStats(&programCache);
+
+	GLCProgramReflection reflection, perMeshReflection;
+
+	if (!glcReflectProgram(&reflection, program) || !glcReflectProgram(&perMeshReflection, perMeshProgram))
+		return EXIT_FAILURE;
+
+	const GLint positionLocation = glcReflectionGetAttribLocation(&reflection, glcInternName("position"));
+	const GLint normalLocation   = glcReflectionGetAttribLocation(&reflection, glcInternName("normal"));
+	const GLint modelLocation    = glcReflectionGetAttribLocation(&reflection, glcInternName("model"));
+
+	const GLint viewProjectionLocation = glcReflectionGetUniformLocation(&reflection, glcInternName("viewProjection"));
+
+	const GLint perMeshPositionLocation = glcReflectionGetAttribLocation(&perMeshReflection, glcInternName("position"));
+	const GLint perMeshNormalLocation   = glcReflectionGetAttribLocation(&perMeshReflection, glcInternName("normal"));
+
+	const GLint perMeshModelLocation          = glcReflectionGetUniformLocation(&perMeshReflection, glcInternName("model"));
+	const GLint perMeshViewProjectionLocation = glcReflectionGetUniformLocation(&perMeshReflection, glcInternName("viewProjection"));
+
+	if ((positionLocation == -1) || (normalLocation == -1) || (modelLocation == -1) ||
+	    (perMeshPositionLocation == -1) || (perMeshNormalLocation == -1))
+		return EXIT_FAILURE;
+
+	static const GLsizei vertexSize = GLC_CUBE_VERTEX_SIZE;
+	static const GLsizei vertexCount = glcCubeVertexCount;
+
+	// Every mesh is a box of its own proportions, placed in a grid
+	int gridSize = 1;
+
+	while (gridSize * gridSize * gridSize < meshCount)
+		++gridSize;
+
+	static const float spacing = 1.5f;
+
+	float *models = (float*) malloc((size_t) meshCount * 16 * sizeof(float));
+	GLfloat *vertices = (GLfloat*) malloc((size_t) meshCount * sizeof(glcCubeVertices));
+
+	// Only needed by the per-mesh path, created once it is used
+	GLuint *perMeshVaos = NULL, *perMeshVbos = NULL;
+
+	if (!models || !vertices)
+		return EXIT_FAILURE;
+
+	for (int i = 0; i < meshCount; ++i)
+	{
+		const float x = ((float) (i % gridSize) - (float) (gridSize - 1) * 0.5f) * spacing;
+		const float y = ((float) ((i / gridSize) % gridSize) - (float) (gridSize - 1) * 0.5f) * spacing;
+		const float z = ((float) (i / (gridSize * gridSize)) - (float) (gridSize - 1) * 0.5f) * spacing;
+
+		mat4Translation(models + i * 16, x, y, z);
+		mat4Rotate(models + i * 16, (float) i * 0.7f, 0.0f, 1.0f, 0.0f);
+
+		const float width  = 0.3f + hashUnit((unsigned int) i * 3 + 0) * 0.9f;
+		const float height = 0.3f + hashUnit((unsigned int) i * 3 + 1) * 0.9f;
+		const float depth  = 0.3f + hashUnit((unsigned int) i * 3 + 2) * 0.9f;
+
+		GLfloat *box = vertices + (size_t) i * vertexCount * vertexSize;
+		memcpy(box, glcCubeVertices, sizeof(glcCubeVertices));
+
+		for (GLsizei vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			box[vertex * vertexSize + 0] *= width;
+			box[vertex * vertexSize + 1] *= height;
+			box[vertex * vertexSize + 2] *= depth;
+		}
+	}
+
+	GLCStateCache state;
+	glcStateInit(&state);
+
+	GLuint instanceVbo;
+
+	glGenBuffers(1, &instanceVbo);
+	glcStateBindBuffer(&state, GL_ARRAY_BUFFER, instanceVbo);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) meshCount * 16 * sizeof(float), models, GL_STATIC_DRAW);
+
+	GLCMeshBuffer meshBuffer;
+
+	if (!glcMeshBufferCreate(&meshBuffer, &state, vertexSize * sizeof(GLfloat), (GLuint) (meshCount * vertexCount), (GLuint) (meshCount * vertexCount)))
+		return EXIT_FAILURE;
+
+	glcMeshBufferAttribute(&meshBuffer, &state, (GLuint)positionLocation, 3, 0);
+	glcMeshBufferAttribute(&meshBuffer, &state, (GLuint)normalLocation, 3, 3 * sizeof(GLfloat));
+	glcMeshBufferInstanceAttribute(&meshBuffer, &state, (GLuint)modelLocation, instanceVbo, 4);
+
+	for (int i = 0; i < meshCount; ++i)
+	{
+		if (glcMeshBufferAdd(&meshBuffer, &state, vertices + (size_t) i * vertexCount * vertexSize, (GLuint) vertexCount, NULL, 0) == -1)
+			return EXIT_FAILURE;
+	}
+
+	GLCMultiDraw multiDraw;
+
+	if (!glcMultiDrawCreate(&multiDraw, &state, (size_t) meshCount, (path == perMeshPath) ? GLC_MULTI_DRAW_INDIRECT : (GLCMultiDrawPath) path))
+		return EXIT_FAILURE;
+
+	if (path != perMeshPath)
+		path = multiDraw.path;
+
+	glcStateEnable(&state, GL_DEPTH_TEST);
+	glcStateEnable(&state, GL_CULL_FACE);
+
+	float view[16], projection[16], viewProjection[16];
+
+	// Far enough back to see the whole grid
+	const float extent = (float) gridSize * spacing;
+	const float distance = extent + 1.0f;
+
+	static const float fov = 70.0f;
+	static const float zNear = 0.01f;
+	const float zFar = distance + extent * 2.0f;
+
+	int spaceDown = 0;
+
+	double cpuTime = 0.0;
+	int cpuFrames = 0;
+	double reportTime = glfwGetTime();
+
+	while (!glfwWindowShouldClose(window))
+	{
+		const int space = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+
+		if (space && !spaceDown)
+		{
+			// Skipping the mesh buffer paths the context does not support
+			do
+				path = (path + 1) % (perMeshPath + 1);
+			while ((path != perMeshPath) && !glcIsMultiDrawPathSupported((GLCMultiDrawPath) path));
+
+			if (path != perMeshPath)
+			{
+				glcMultiDrawDestroy(&multiDraw, &state);
+
+				if (!glcMultiDrawCreate(&multiDraw, &state, (size_t) meshCount, (GLCMultiDrawPath) path))
+					break;
+			}
+
+			cpuTime = 0.0;
+			cpuFrames = 0;
+		}
+
+		spaceDown = space;
+
+		int viewportWidth, viewportHeight;
+		glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+
+		// Everything up to the swap, which waits for the GPU
+		const double frameStart = glfwGetTime();
+
+		const float aspect = static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight);
+		const float time = static_cast<GLfloat>(frameStart);
+
+		mat4Translation(view, 0.0f, 0.0f, -distance);
+		mat4Rotate(view, time, 0.0f, 1.0f, 0.0f);
+
+		mat4Perspective(projection, fov, aspect, zNear, zFar);
+		mat4Multiply(viewProjection, projection, view);
+
+		glcStateViewport(&state, 0, 0, viewportWidth, viewportHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		if (path != perMeshPath)
+		{
+			glcStateUseProgram(&state, program);
+			glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, viewProjection);
+
+			glcMultiDrawBeginFrame(&multiDraw, &state);
+
+			for (int i = 0; i < meshCount; ++i)
+				glcMultiDrawPush(&multiDraw, &meshBuffer, i, 1, (GLuint) i);
+
+			glcMultiDrawSubmit(&multiDraw, &meshBuffer, &state);
+			glcMultiDrawEndFrame(&multiDraw, &state);
+		}
+		else
+		{
+			if (!perMeshVaos)
+			{
+				perMeshVaos = (GLuint*) malloc((size_t) meshCount * sizeof(GLuint));
+				perMeshVbos = (GLuint*) malloc((size_t) meshCount * sizeof(GLuint));
+
+				if (!perMeshVaos || !perMeshVbos)
+					break;
+
+				glGenVertexArrays(meshCount, perMeshVaos);
+				glGenBuffers(meshCount, perMeshVbos);
+
+				for (int i = 0; i < meshCount; ++i)
+				{
+					glcStateBindVertexArray(&state, perMeshVaos[i]);
+
+					glcStateBindBuffer(&state, GL_ARRAY_BUFFER, perMeshVbos[i]);
+					glBufferData(GL_ARRAY_BUFFER, sizeof(glcCubeVertices), vertices + (size_t) i * vertexCount * vertexSize, GL_STATIC_DRAW);
+
+					glEnableVertexAttribArray((GLuint)perMeshPositionLocation);
+					glVertexAttribPointer((GLuint)perMeshPositionLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), 0);
+
+					glEnableVertexAttribArray((GLuint)perMeshNormalLocation);
+					glVertexAttribPointer((GLuint)perMeshNormalLocation, 3, GL_FLOAT, GL_FALSE, vertexSize * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+				}
+			}
+
+			glcStateUseProgram(&state, perMeshProgram);
+			glUniformMatrix4fv(perMeshViewProjectionLocation, 1, GL_FALSE, viewProjection);
+
+			for (int i = 0; i < meshCount; ++i)
+			{
+				glcStateBindVertexArray(&state, perMeshVaos[i]);
+				glUniformMatrix4fv(perMeshModelLocation, 1, GL_FALSE, models + i * 16);
+				glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+			}
+		}
+
+		cpuTime += glfwGetTime() - frameStart;
+		++cpuFrames;
+
+		if (glfwGetTime() - reportTime >= 1.0)
+		{
+			printf("%s: %d meshes, %.3f ms CPU per frame\n", (path == perMeshPath) ? "PerMesh" : glcGetMultiDrawPathString((GLCMultiDrawPath) path),
+			       meshCount, cpuTime * 1000.0 / (double) cpuFrames);
+
+			cpuTime = 0.0;
+			cpuFrames = 0;
+			reportTime = glfwGetTime();
+		}
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	glcMultiDrawPrintStats(&multiDraw);
+	glcStatePrintStats(&state);
+
+	if (perMeshVaos && perMeshVbos)
+	{
+		glcStateDeleteVertexArrays(&state, meshCount, perMeshVaos);
+		glcStateDeleteBuffers(&state, meshCount, perMeshVbos);
+	}
+
+	free(perMeshVbos);
+	free(perMeshVaos);
+
+	glcMultiDrawDestroy(&multiDraw, &state);
+	glcMeshBufferDestroy(&meshBuffer, &state);
+
+	glcStateDeleteBuffers(&state, 1, &instanceVbo);
+
+	free(vertices);
+	free(models);
+
+	glcReflectionDestroy(&perMeshReflection);
+	glcReflectionDestroy(&reflection);
+
+	glcStateDeleteProgram(&state, perMeshProgram);
+	glcStateDeleteProgram(&state, program);
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	return EXIT_SUCCESS;
+}
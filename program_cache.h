@@ -0,0 +1,352 @@
+#ifndef GLC_PROGRAM_CACHE_H
+#define GLC_PROGRAM_CACHE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#	include <direct.h>
+#else
+#	include <sys/stat.h>
+#endif
+
+#include "gl.h"
+#include "shader.h"
+
+#define GLC_PROGRAM_CACHE_DIRECTORY "program_cache"
+
+#define GLC_PROGRAM_CACHE_MAGIC   0x50434C47 // "GLCP"
+#define GLC_PROGRAM_CACHE_VERSION 3
+
+// Everything glcLinkProgram does besides attaching shaders, which changes
+// the resulting binary and therefore has to be part of the key. Validation
+// is optional and leaves the binary as is
+#define GLC_PROGRAM_CACHE_LINK_OPTIONS "fragColor=0"
+
+typedef struct GLCProgramCacheStats
+{
+	unsigned int hits, misses, rejected, stores;
+
+	// Seconds spent loading binaries on hits, and compiling and linking on misses
+	double loadTime, compileTime;
+} GLCProgramCacheStats;
+
+typedef struct GLCProgramCache
+{
+	char directory[256];
+
+	// Hash of the driver vendor, renderer and version, which every key starts from
+	uint64_t driverHash;
+
+	int supported;
+
+	GLCProgramCacheStats stats;
+} GLCProgramCache;
+
+typedef struct GLCProgramCacheHeader
+{
+	uint32_t magic, version;
+	uint64_t key;
+	uint32_t format, length;
+} GLCProgramCacheHeader;
+
+// 64-bit FNV-1a
+uint64_t glcHash(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char*) data;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+// Includes the terminator, such that "ab" + "c" differs from "a" + "bc"
+uint64_t glcHashString(uint64_t hash, const char *str)
+{
+	if (!str)
+		str = "";
+
+	return glcHash(hash, str, strlen(str) + 1);
+}
+
+// Requires a current context. Programs are still created if binaries are
+// not supported, they are just never cached
+void glcProgramCacheInit(GLCProgramCache *cache, const char *directory = GLC_PROGRAM_CACHE_DIRECTORY)
+{
+	memset(cache, 0, sizeof(GLCProgramCache));
+
+	snprintf(cache->directory, sizeof(cache->directory), "%s", directory);
+
+#ifdef _WIN32
+	_mkdir(cache->directory);
+#else
+	mkdir(cache->directory, 0755);
+#endif
+
+	uint64_t hash = 0xCBF29CE484222325ull;
+	hash = glcHashString(hash, (const char*) glGetString(GL_VENDOR));
+	hash = glcHashString(hash, (const char*) glGetString(GL_RENDERER));
+	hash = glcHashString(hash, (const char*) glGetString(GL_VERSION));
+
+	cache->driverHash = hash;
+
+	GLint formatCount = 0;
+
+	if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	cache->supported = formatCount > 0;
+}
+
+// Hash of a single source, the same as the precomputed GLCEmbeddedFile::hash
+uint64_t glcHashSource(const GLchar *source)
+{
+	return glcHashString(0xCBF29CE484222325ull, source);
+}
+
+// Combines hashes of the individual sources, such that embedded shaders
+// never have to be hashed at runtime
+uint64_t glcProgramCacheKeyHashes(const GLCProgramCache *cache, uint64_t vertexHash, uint64_t fragmentHash, uint64_t geometryHash)
+{
+	const uint64_t hashes[3] = { vertexHash, fragmentHash, geometryHash };
+
+	uint64_t hash = cache->driverHash;
+	hash = glcHash(hash, hashes, sizeof(hashes));
+	hash = glcHashString(hash, GLC_PROGRAM_CACHE_LINK_OPTIONS);
+
+	return hash;
+}
+
+uint64_t glcProgramCacheKey(const GLCProgramCache *cache, const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource)
+{
+	return glcProgramCacheKeyHashes(cache, glcHashSource(vertexSource), glcHashSource(fragmentSource), glcHashSource(geometrySource));
+}
+
+void glcProgramCachePath(const GLCProgramCache *cache, uint64_t key, char *path, size_t size)
+{
+	snprintf(path, size, "%s/%016llx.bin", cache->directory, (unsigned long long) key);
+}
+
+// Returns GLC_NULL_HANDLE if there is no binary, or the driver rejects it
+GLuint glcProgramCacheLoad(GLCProgramCache *cache, uint64_t key)
+{
+	char path[300];
+	glcProgramCachePath(cache, key, path, sizeof(path));
+
+	FILE *f = fopen(path, "rb");
+
+	if (!f)
+		return GLC_NULL_HANDLE;
+
+	GLCProgramCacheHeader header;
+	void *binary = NULL;
+
+	const int valid = (fread(&header, sizeof(header), 1, f) == 1) &&
+	                  (header.magic == GLC_PROGRAM_CACHE_MAGIC) &&
+	                  (header.version == GLC_PROGRAM_CACHE_VERSION) &&
+	                  (header.key == key) && (header.length > 0) &&
+	                  ((binary = malloc(header.length)) != NULL) &&
+	                  (fread(binary, 1, header.length, f) == header.length);
+
+	fclose(f);
+
+	if (!valid)
+	{
+		free(binary);
+		return GLC_NULL_HANDLE;
+	}
+
+	GLuint program = glCreateProgram();
+
+	if (program != GLC_NULL_HANDLE)
+	{
+		glProgramBinary(program, (GLenum) header.format, binary, (GLsizei) header.length);
+
+		// Drivers reject binaries after updates, regardless of the version string
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+		if (!status)
+		{
+			glDeleteProgram(program);
+			program = GLC_NULL_HANDLE;
+
+			++cache->stats.rejected;
+			remove(path);
+		}
+	}
+
+	free(binary);
+
+	return program;
+}
+
+void glcProgramCacheStore(GLCProgramCache *cache, uint64_t key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+		return;
+
+	void *binary = malloc((size_t) length);
+
+	if (!binary)
+		return;
+
+	GLenum format;
+	glGetProgramBinary(program, length, &length, &format, binary);
+
+	char path[300];
+	glcProgramCachePath(cache, key, path, sizeof(path));
+
+	FILE *f = fopen(path, "wb");
+
+	if (f)
+	{
+		GLCProgramCacheHeader header;
+		memset(&header, 0, sizeof(header));
+
+		header.magic = GLC_PROGRAM_CACHE_MAGIC;
+		header.version = GLC_PROGRAM_CACHE_VERSION;
+		header.key = key;
+		header.format = (uint32_t) format;
+		header.length = (uint32_t) length;
+
+		const int written = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+		                    (fwrite(binary, 1, (size_t) length, f) == (size_t) length);
+
+		fclose(f);
+
+		// Never leave a truncated binary behind
+		if (written)
+			++cache->stats.stores;
+		else
+			remove(path);
+	}
+
+	free(binary);
+}
+
+// Loads the program with the key from the cache, or compiles, links and
+// stores it
+GLuint glcProgramCacheCreateProgramKey(GLCProgramCache *cache, uint64_t key, const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource = NULL)
+{
+	const double start = glfwGetTime();
+
+	GLCShaderProfile *profile = glcGetShaderProfile();
+
+	if (cache->supported)
+	{
+		const GLuint program = glcProgramCacheLoad(cache, key);
+
+		if (program != GLC_NULL_HANDLE)
+		{
+			++cache->stats.hits;
+			cache->stats.loadTime += glfwGetTime() - start;
+
+			profile->cacheStatus = GLC_SHADER_CACHE_HIT;
+			glcShaderProfileRecord(GLC_SHADER_EVENT_CACHE_LOAD, 0, program, 0, 1, start);
+			profile->cacheStatus = GLC_SHADER_CACHE_NONE;
+
+			return program;
+		}
+	}
+
+	++cache->stats.misses;
+
+	// Compiles and links below are attributed to the miss
+	profile->cacheStatus = GLC_SHADER_CACHE_MISS;
+
+	const GLuint vertexShader = glcCreateShader(GL_VERTEX_SHADER, vertexSource);
+	const GLuint fragmentShader = glcCreateShader(GL_FRAGMENT_SHADER, fragmentSource);
+	const GLuint geometryShader = geometrySource ? glcCreateShader(GL_GEOMETRY_SHADER, geometrySource) : GLC_NULL_HANDLE;
+
+	GLuint program = GLC_NULL_HANDLE;
+
+	if ((vertexShader != GLC_NULL_HANDLE) && (fragmentShader != GLC_NULL_HANDLE) && (!geometrySource || (geometryShader != GLC_NULL_HANDLE)))
+		program = glCreateProgram();
+
+	if (program != GLC_NULL_HANDLE)
+	{
+		if (cache->supported)
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		if (!glcLinkProgram(program, vertexShader, fragmentShader, geometryShader))
+		{
+			glDeleteProgram(program);
+			program = GLC_NULL_HANDLE;
+		}
+	}
+
+	if (geometryShader != GLC_NULL_HANDLE)
+		glDeleteShader(geometryShader);
+	if (fragmentShader != GLC_NULL_HANDLE)
+		glDeleteShader(fragmentShader);
+	if (vertexShader != GLC_NULL_HANDLE)
+		glDeleteShader(vertexShader);
+
+	profile->cacheStatus = GLC_SHADER_CACHE_NONE;
+
+	if ((program != GLC_NULL_HANDLE) && cache->supported)
+		glcProgramCacheStore(cache, key, program);
+
+	cache->stats.compileTime += glfwGetTime() - start;
+
+	return program;
+}
+
+GLuint glcProgramCacheCreateProgram(GLCProgramCache *cache, const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource = NULL)
+{
+	const uint64_t key = glcProgramCacheKey(cache, vertexSource, fragmentSource, geometrySource);
+
+	return glcProgramCacheCreateProgramKey(cache, key, vertexSource, fragmentSource, geometrySource);
+}
+
+GLuint glcProgramCacheCreateProgramFromFiles(GLCProgramCache *cache, const char *vertexFilename, const char *fragmentFilename, const char *geometryFilename = NULL)
+{
+	const GLCEmbeddedFile *vertexFile = glcGetEmbeddedFile(vertexFilename);
+	const GLCEmbeddedFile *fragmentFile = glcGetEmbeddedFile(fragmentFilename);
+	const GLCEmbeddedFile *geometryFile = geometryFilename ? glcGetEmbeddedFile(geometryFilename) : NULL;
+
+	// All embedded, the key comes from the precomputed hashes
+	if (vertexFile && fragmentFile && (!geometryFilename || geometryFile))
+	{
+		const uint64_t key = glcProgramCacheKeyHashes(cache, vertexFile->hash, fragmentFile->hash,
+		                                              geometryFile ? geometryFile->hash : glcHashSource(NULL));
+
+		return glcProgramCacheCreateProgramKey(cache, key, vertexFile->data, fragmentFile->data, geometryFile ? geometryFile->data : NULL);
+	}
+
+	char *vertexSource = glcReadFile(vertexFilename);
+	char *fragmentSource = glcReadFile(fragmentFilename);
+	char *geometrySource = geometryFilename ? glcReadFile(geometryFilename) : NULL;
+
+	GLuint program = GLC_NULL_HANDLE;
+
+	if (vertexSource && fragmentSource && (!geometryFilename || geometrySource))
+		program = glcProgramCacheCreateProgram(cache, vertexSource, fragmentSource, geometrySource);
+
+	free(geometrySource);
+	free(fragmentSource);
+	free(vertexSource);
+
+	return program;
+}
+
+void glcProgramCachePrintStats(const GLCProgramCache *cache)
+{
+	const GLCProgramCacheStats *stats = &cache->stats;
+
+	printf("Program Cache: %u hits (%.3f ms), %u misses (%.3f ms), %u rejected, %u stored%s\n",
+	       stats->hits, stats->loadTime * 1000.0, stats->misses, stats->compileTime * 1000.0,
+	       stats->rejected, stats->stores, cache->supported ? "" : ", binaries not supported");
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 #include "gl.h"
 #include "shader.h"
+#include "program_cache.h"
+#include "shader_reflection.h"
 #include "glfw_utilities.h"
 
 int main(int argc, char *argv[])
@@ -67,26 +69,27 @@ int main(int argc, char *argv[])
 			"    fragColor = vec4(sin(time + vTexCoord.xyx + vec3(0.0, 2.0, 4.0)) * 0.5 + 0.5, 1.0);\n"
 			"}\n";
 
-	const GLuint vertexShader = glcCreateShader(GL_VERTEX_SHADER, vertexShaderSource);
-	const GLuint fragmentShader = glcCreateShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+	GLCProgramCache programCache;
+	glcProgramCacheInit(&programCache);
 
-	if ((vertexShader == GLC_NULL_HANDLE) || (fragmentShader == GLC_NULL_HANDLE))
-		return EXIT_FAILURE;
-
-	const GLuint program = glcCreateProgram(vertexShader, fragmentShader);
+	const GLuint program = glcProgramCacheCreateProgram(&programCache, vertexShaderSource, fragmentShaderSource);
 
 	if (program == GLC_NULL_HANDLE)
 		return EXIT_FAILURE;
 
-	glDeleteShader(fragmentShader);
-	glDeleteShader(vertexShader);
+	glcProgramCachePrintStats(&programCache);
 
 	glUseProgram(program);
 
-	const GLint positionLocation = glGetAttribLocation(program, "position");
-	const GLint texCoordLocation = glGetAttribLocation(program, "texCoord");
+	GLCProgramReflection reflection;
+
+	if (!glcReflectProgram(&reflection, program))
+		return EXIT_FAILURE;
+
+	const GLint positionLocation = glcReflectionGetAttribLocation(&reflection, glcInternName("position"));
+	const GLint texCoordLocation = glcReflectionGetAttribLocation(&reflection, glcInternName("texCoord"));
 
-	const GLint timeLocation = glGetUniformLocation(program, "time");
+	const GLint timeLocation = glcReflectionGetUniformLocation(&reflection, glcInternName("time"));
 
 	if ((positionLocation == -1) || (texCoordLocation == -1))
 		return EXIT_FAILURE;
@@ -136,6 +139,7 @@ int main(int argc, char *argv[])
 	glDeleteVertexArrays(1, &vao);
 	glDeleteBuffers(1, &vbo);
 
+	glcReflectionDestroy(&reflection);
 	glDeleteProgram(program);
 
 	glfwDestroyWindow(window);
@@ -2,9 +2,12 @@
 #define GLC_SHADER_H
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <stdio.h>
 
 #include "gl.h"
+#include "shader_profile.h"
 
 #define GLC_ATTRIBUTE_POSITION 0
 #define GLC_ATTRIBUTE_TEXCOORD 1
@@ -13,6 +16,14 @@
 #define _GLC_STRINGIFY(x) #x
 #define GLC_STRINGIFY(x) _GLC_STRINGIFY(x)
 
+// glValidateProgram can cost as much as linking, and only reports problems
+// with the current state, so it can be turned off
+#ifndef GLC_SHADER_VALIDATE
+#	define GLC_SHADER_VALIDATE 1
+#endif
+
+int glcShaderValidate = GLC_SHADER_VALIDATE;
+
 const char* glcGetShaderTypeString(GLenum type)
 {
 	switch (type)
@@ -75,21 +86,36 @@ void glcCheckProgramLog(GLuint program)
 	}
 }
 
-GLuint glcCreateShader(GLenum type, const GLchar *source)
+// Compiles count strings as one shader, lengths may be NULL if all strings
+// are null terminated
+GLuint glcCreateShaderSources(GLenum type, GLsizei count, const GLchar *const *sources, const GLint *lengths)
 {
 	GLuint shader = glCreateShader(type);
 
 	if (shader == GLC_NULL_HANDLE)
 		return GLC_NULL_HANDLE;
 
-	glShaderSource(shader, 1, &source, NULL);
-	glCompileShader(shader);
+	const double start = glcShaderProfileBegin();
 
-	glcCheckShaderLog(shader);
+	glShaderSource(shader, count, sources, lengths);
+	glCompileShader(shader);
 
+	// Drivers may defer compiling until the status is queried
 	GLint status;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 
+	if (glcGetShaderProfile()->enabled)
+	{
+		size_t sourceSize = 0;
+
+		for (GLsizei i = 0; i < count; ++i)
+			sourceSize += (lengths && (lengths[i] >= 0)) ? (size_t) lengths[i] : strlen(sources[i]);
+
+		glcShaderProfileRecord(GLC_SHADER_EVENT_COMPILE, type, shader, sourceSize, status, start);
+	}
+
+	glcCheckShaderLog(shader);
+
 	if (status)
 		return shader;
 
@@ -98,12 +124,72 @@ GLuint glcCreateShader(GLenum type, const GLchar *source)
 	return GLC_NULL_HANDLE;
 }
 
-GLuint glcCreateShaderFromFile(GLenum type, const char *filename)
+GLuint glcCreateShader(GLenum type, const GLchar *source)
+{
+	return glcCreateShaderSources(type, 1, &source, NULL);
+}
+
+// A file compiled into the executable, see cmake/embed_shaders.cmake
+typedef struct GLCEmbeddedFile
+{
+	const char *path;
+
+	// Null terminated
+	const char *data;
+	size_t length;
+
+	// glcHashString of the data
+	uint64_t hash;
+} GLCEmbeddedFile;
+
+#ifdef GLC_EMBEDDED_SHADERS
+#	include "embedded_shaders.h"
+#endif
+
+// When set, files on disk are preferred over the embedded copies, such that
+// shaders can be edited without rebuilding
+#ifndef GLC_SHADERS_PREFER_DISK
+#	define GLC_SHADERS_PREFER_DISK 0
+#endif
+
+int glcShadersPreferDisk = GLC_SHADERS_PREFER_DISK;
+
+// Returns NULL if the path was not embedded
+const GLCEmbeddedFile* glcFindEmbeddedFile(const char *path)
+{
+#ifdef GLC_EMBEDDED_SHADERS
+	if ((path[0] == '.') && (path[1] == '/'))
+		path += 2;
+
+	size_t first = 0, last = glcEmbeddedFileCount;
+
+	while (first < last)
+	{
+		const size_t middle = first + (last - first) / 2;
+		const int order = strcmp(path, glcEmbeddedFiles[middle].path);
+
+		if (order == 0)
+			return glcEmbeddedFiles + middle;
+		else if (order < 0)
+			last = middle;
+		else
+			first = middle + 1;
+	}
+#else
+	(void) path;
+#endif
+
+	return NULL;
+}
+
+// Returns the contents of the file as a null terminated string, which must
+// be freed, or NULL on failure. Always reads from disk
+char* glcReadFileFromDisk(const char *filename)
 {
 	FILE *f = fopen(filename, "r");
 
 	if (!f)
-		return GLC_NULL_HANDLE;
+		return NULL;
 
 	fseek(f, 0, SEEK_END);
 	const size_t len = (size_t) ftell(f);
@@ -114,7 +200,7 @@ GLuint glcCreateShaderFromFile(GLenum type, const char *filename)
 	if (!str)
 	{
 		fclose(f);
-		return GLC_NULL_HANDLE;
+		return NULL;
 	}
 
 	size_t read = 0;
@@ -125,20 +211,50 @@ GLuint glcCreateShaderFromFile(GLenum type, const char *filename)
 
 	fclose(f);
 
-	GLuint shader = glcCreateShader(type, str);
+	return str;
+}
+
+// Returns the embedded file if there is one, otherwise NULL. Files on disk
+// win if glcShadersPreferDisk is set and the file exists
+const GLCEmbeddedFile* glcGetEmbeddedFile(const char *filename)
+{
+	const GLCEmbeddedFile *embedded = glcFindEmbeddedFile(filename);
+
+	if (embedded && glcShadersPreferDisk)
+	{
+		FILE *f = fopen(filename, "r");
 
-	free(str);
+		if (f)
+		{
+			fclose(f);
+			return NULL;
+		}
+	}
 
-	return shader;
+	return embedded;
 }
 
-GLuint glcCreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = GLC_NULL_HANDLE)
+// Like glcReadFileFromDisk, but returns a copy of the embedded file instead,
+// if there is one
+char* glcReadFile(const char *filename)
 {
-	GLuint program = glCreateProgram();
+	const GLCEmbeddedFile *embedded = glcGetEmbeddedFile(filename);
 
-	if (program == GLC_NULL_HANDLE)
-		return GLC_NULL_HANDLE;
+	if (!embedded)
+		return glcReadFileFromDisk(filename);
+
+	char *str = (char*) malloc(embedded->length + 1);
+
+	if (str)
+		memcpy(str, embedded->data, embedded->length + 1);
+
+	return str;
+}
 
+// Attaches the shaders, links and validates the program if
+// glcShaderValidate is set, and detaches the shaders again. Returns 0 on failure
+int glcLinkProgram(GLuint program, GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = GLC_NULL_HANDLE)
+{
 	glAttachShader(program, vertexShader);
 	glAttachShader(program, fragmentShader);
 
@@ -147,27 +263,27 @@ GLuint glcCreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geome
 
 	glBindFragDataLocation(program, 0, "fragColor");
 
+	double start = glcShaderProfileBegin();
+
 	glLinkProgram(program);
-	glcCheckProgramLog(program);
 
 	GLint status;
 	glGetProgramiv(program, GL_LINK_STATUS, &status);
 
-	if (!status)
-	{
-		glDeleteProgram(program);
-		return GLC_NULL_HANDLE;
-	}
+	glcShaderProfileRecord(GLC_SHADER_EVENT_LINK, 0, program, 0, status, start);
 
-	glValidateProgram(program);
 	glcCheckProgramLog(program);
 
-	glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
-
-	if (!status)
+	if (status && glcShaderValidate)
 	{
-		glDeleteProgram(program);
-		return GLC_NULL_HANDLE;
+		start = glcShaderProfileBegin();
+
+		glValidateProgram(program);
+		glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
+
+		glcShaderProfileRecord(GLC_SHADER_EVENT_VALIDATE, 0, program, 0, status, start);
+
+		glcCheckProgramLog(program);
 	}
 
 	glDetachShader(program, vertexShader);
@@ -176,7 +292,26 @@ GLuint glcCreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geome
 	if (geometryShader != GLC_NULL_HANDLE)
 		glDetachShader(program, geometryShader);
 
+	return status ? 1 : 0;
+}
+
+GLuint glcCreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = GLC_NULL_HANDLE)
+{
+	GLuint program = glCreateProgram();
+
+	if (program == GLC_NULL_HANDLE)
+		return GLC_NULL_HANDLE;
+
+	if (!glcLinkProgram(program, vertexShader, fragmentShader, geometryShader))
+	{
+		glDeleteProgram(program);
+		return GLC_NULL_HANDLE;
+	}
+
 	return program;
 }
 
+// glcCreateShaderFromFile resolves #include through the include cache
+#include "shader_include.h"
+
 #endif
\ No newline at end of file
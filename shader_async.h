@@ -0,0 +1,422 @@
+#ifndef GLC_SHADER_ASYNC_H
+#define GLC_SHADER_ASYNC_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "gl.h"
+#include "shader.h"
+
+#define GLC_ASYNC_STAGE_COUNT 3
+
+typedef enum GLCAsyncStatus
+{
+	GLC_ASYNC_PENDING,
+	GLC_ASYNC_READY,
+	GLC_ASYNC_FAILED,
+} GLCAsyncStatus;
+
+typedef enum GLCCompileMode
+{
+	// Submitting compiles and links immediately, the only mode without a driver or thread to defer to
+	GLC_COMPILE_IMMEDIATE,
+	// GL_KHR_parallel_shader_compile, the driver compiles in the background
+	GLC_COMPILE_PARALLEL,
+	// A worker thread compiles using a hidden context sharing objects with the main one
+	GLC_COMPILE_WORKER,
+} GLCCompileMode;
+
+static const GLenum glcAsyncStageTypes[GLC_ASYNC_STAGE_COUNT] = {
+		GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER,
+};
+
+// Must stay at the same address until it is no longer pending
+typedef struct GLCAsyncProgram
+{
+	GLuint program;
+	GLuint shaders[GLC_ASYNC_STAGE_COUNT];
+
+	// Copies of the sources, only kept until the worker is done with them
+	char *sources[GLC_ASYNC_STAGE_COUNT];
+
+	// Whether profiling was enabled when submitted, as the worker must not
+	// touch the profile itself
+	int profiled;
+	size_t sourceSizes[GLC_ASYNC_STAGE_COUNT];
+	double started;
+
+	// Timed by whichever thread finishes the program, and added to the
+	// profile on the main thread once it is no longer pending. One build span
+	// and the validation
+	GLCShaderEvent events[2];
+	int eventCount;
+
+	std::atomic<int> status;
+} GLCAsyncProgram;
+
+typedef struct GLCShaderCompiler
+{
+	GLCCompileMode mode;
+
+	GLFWwindow *workerWindow;
+	std::thread worker;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<GLCAsyncProgram*> queue;
+	bool stop;
+
+	// Signaled by the worker each time it finishes a program
+	std::condition_variable finished;
+} GLCShaderCompiler;
+
+const char* glcGetCompileModeString(GLCCompileMode mode)
+{
+	switch (mode)
+	{
+	case GLC_COMPILE_IMMEDIATE:
+		return "Immediate";
+	case GLC_COMPILE_PARALLEL:
+		return "Parallel";
+	case GLC_COMPILE_WORKER:
+		return "Worker";
+	default:
+		return "Unknown";
+	}
+}
+
+void glcAsyncProgramAddEvent(GLCAsyncProgram *asyncProgram, GLCShaderEventKind kind, GLenum shaderType, GLuint object, size_t sourceSize, int success, double start)
+{
+	GLCShaderEvent *event = asyncProgram->events + asyncProgram->eventCount++;
+
+	event->kind = kind;
+	event->shaderType = shaderType;
+	event->object = object;
+	event->sourceSize = sourceSize;
+	event->cacheStatus = GLC_SHADER_CACHE_NONE;
+	event->success = success;
+	event->start = start;
+	event->duration = glfwGetTime() - start;
+}
+
+// Adds the events of a finished program to the profile, on the main thread
+void glcAsyncProgramRecord(GLCAsyncProgram *asyncProgram)
+{
+	for (int i = 0; i < asyncProgram->eventCount; ++i)
+		glcShaderProfileAppend(asyncProgram->events + i);
+
+	asyncProgram->eventCount = 0;
+}
+
+// Checks the compile and link status and logs, validates if validate is set,
+// and detaches and deletes the shaders. Only called once compiling and linking
+// has completed, such that none of the queries block. Compiling and linking
+// is recorded as one build span, as the driver does not say when each stage
+// finished. The worker starts it when it picks the program up, so it is the
+// build itself. In parallel mode it starts at submission and ends once the
+// completion was polled, so it includes the polling latency
+int glcAsyncProgramFinish(GLCAsyncProgram *asyncProgram, int validate)
+{
+	const GLuint program = asyncProgram->program;
+
+	GLint status;
+	size_t sourceSize = 0;
+
+	for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+	{
+		if (asyncProgram->shaders[i] == GLC_NULL_HANDLE)
+			continue;
+
+		sourceSize += asyncProgram->sourceSizes[i];
+
+		glcCheckShaderLog(asyncProgram->shaders[i]);
+	}
+
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+	if (asyncProgram->profiled)
+		glcAsyncProgramAddEvent(asyncProgram, GLC_SHADER_EVENT_ASYNC_BUILD, 0, program, sourceSize, status, asyncProgram->started);
+
+	glcCheckProgramLog(program);
+
+	if (status && validate)
+	{
+		const double start = glfwGetTime();
+
+		glValidateProgram(program);
+		glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
+
+		if (asyncProgram->profiled)
+			glcAsyncProgramAddEvent(asyncProgram, GLC_SHADER_EVENT_VALIDATE, 0, program, 0, status, start);
+
+		glcCheckProgramLog(program);
+	}
+
+	for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+	{
+		if (asyncProgram->shaders[i] == GLC_NULL_HANDLE)
+			continue;
+
+		glDetachShader(program, asyncProgram->shaders[i]);
+		glDeleteShader(asyncProgram->shaders[i]);
+
+		asyncProgram->shaders[i] = GLC_NULL_HANDLE;
+	}
+
+	if (!status)
+	{
+		glDeleteProgram(program);
+		asyncProgram->program = GLC_NULL_HANDLE;
+	}
+
+	return status ? 1 : 0;
+}
+
+// Issues compiling and linking without querying anything
+void glcAsyncProgramStart(GLCAsyncProgram *asyncProgram, const GLchar *const *sources)
+{
+	const GLuint program = glCreateProgram();
+
+	asyncProgram->program = program;
+
+	for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+	{
+		if (!sources[i])
+			continue;
+
+		const GLuint shader = glCreateShader(glcAsyncStageTypes[i]);
+
+		glShaderSource(shader, 1, &sources[i], NULL);
+		glCompileShader(shader);
+
+		glAttachShader(program, shader);
+
+		asyncProgram->shaders[i] = shader;
+	}
+
+	glBindFragDataLocation(program, 0, "fragColor");
+
+	// Linking waits for the compiles internally, and fails if any of them failed
+	glLinkProgram(program);
+}
+
+void glcShaderCompilerWork(GLCShaderCompiler *compiler)
+{
+	glfwMakeContextCurrent(compiler->workerWindow);
+
+	for (;;)
+	{
+		GLCAsyncProgram *asyncProgram;
+
+		{
+			std::unique_lock<std::mutex> lock(compiler->mutex);
+
+			compiler->condition.wait(lock, [compiler]() { return compiler->stop || !compiler->queue.empty(); });
+
+			// Drain the queue before stopping, such that nothing stays pending
+			if (compiler->queue.empty())
+				break;
+
+			asyncProgram = compiler->queue.front();
+			compiler->queue.pop_front();
+		}
+
+		if (asyncProgram->profiled)
+			asyncProgram->started = glfwGetTime();
+
+		glcAsyncProgramStart(asyncProgram, asyncProgram->sources);
+
+		// Validating checks against the current state, which is the worker's
+		const int ready = glcAsyncProgramFinish(asyncProgram, 0);
+
+		for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+		{
+			free(asyncProgram->sources[i]);
+			asyncProgram->sources[i] = NULL;
+		}
+
+		// The program must be complete before the main context may use it
+		glFinish();
+
+		{
+			// Stored under the lock, such that glcWaitProgram cannot miss the signal
+			std::lock_guard<std::mutex> lock(compiler->mutex);
+			asyncProgram->status.store(ready ? GLC_ASYNC_READY : GLC_ASYNC_FAILED, std::memory_order_release);
+		}
+
+		compiler->finished.notify_all();
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+// Must be called on the main thread, with window's context current.
+// threadCount limits the driver's compiler threads, 0 lets it decide.
+// Creating the worker's window resets every window hint to its default, as
+// GLFW cannot query the previous ones, so set hints for later windows after
+void glcShaderCompilerInit(GLCShaderCompiler *compiler, GLFWwindow *window, unsigned int threadCount = 0)
+{
+	compiler->mode = GLC_COMPILE_IMMEDIATE;
+	compiler->workerWindow = NULL;
+	compiler->stop = false;
+
+	if (GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)
+	{
+		const GLuint count = threadCount ? threadCount : 0xFFFFFFFF;
+
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(count);
+		else
+			glMaxShaderCompilerThreadsARB(count);
+
+		compiler->mode = GLC_COMPILE_PARALLEL;
+
+		return;
+	}
+
+	// Windows can only be created on the main thread, the worker just makes it current.
+	// The context hints the application set for window still apply
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	compiler->workerWindow = glfwCreateWindow(1, 1, "", NULL, window);
+	glfwDefaultWindowHints();
+
+	if (!compiler->workerWindow)
+		return;
+
+	compiler->mode = GLC_COMPILE_WORKER;
+	compiler->worker = std::thread(glcShaderCompilerWork, compiler);
+}
+
+// Waits for all submitted programs to be compiled
+void glcShaderCompilerDestroy(GLCShaderCompiler *compiler)
+{
+	if (compiler->mode == GLC_COMPILE_WORKER)
+	{
+		{
+			std::lock_guard<std::mutex> lock(compiler->mutex);
+			compiler->stop = true;
+		}
+
+		compiler->condition.notify_one();
+		compiler->worker.join();
+
+		glfwDestroyWindow(compiler->workerWindow);
+		compiler->workerWindow = NULL;
+	}
+}
+
+// Starts compiling and linking a program without waiting for it. The sources
+// are copied, and geometrySource may be NULL
+void glcSubmitProgram(GLCShaderCompiler *compiler, GLCAsyncProgram *asyncProgram, const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource = NULL)
+{
+	const GLchar *sources[GLC_ASYNC_STAGE_COUNT] = { vertexSource, fragmentSource, geometrySource };
+
+	asyncProgram->program = GLC_NULL_HANDLE;
+
+	for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+	{
+		asyncProgram->shaders[i] = GLC_NULL_HANDLE;
+		asyncProgram->sources[i] = NULL;
+	}
+
+	asyncProgram->profiled = glcGetShaderProfile()->enabled;
+	asyncProgram->started = glcShaderProfileBegin();
+	asyncProgram->eventCount = 0;
+
+	for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+		asyncProgram->sourceSizes[i] = (asyncProgram->profiled && sources[i]) ? strlen(sources[i]) : 0;
+
+	asyncProgram->status.store(GLC_ASYNC_PENDING, std::memory_order_relaxed);
+
+	switch (compiler->mode)
+	{
+	case GLC_COMPILE_PARALLEL:
+		glcAsyncProgramStart(asyncProgram, sources);
+		break;
+
+	case GLC_COMPILE_WORKER:
+		for (int i = 0; i < GLC_ASYNC_STAGE_COUNT; ++i)
+		{
+			if (!sources[i])
+				continue;
+
+			const size_t length = strlen(sources[i]);
+
+			asyncProgram->sources[i] = (char*) malloc(length + 1);
+			memcpy(asyncProgram->sources[i], sources[i], length + 1);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(compiler->mutex);
+			compiler->queue.push_back(asyncProgram);
+		}
+
+		compiler->condition.notify_one();
+		break;
+
+	default:
+		glcAsyncProgramStart(asyncProgram, sources);
+		asyncProgram->status.store(glcAsyncProgramFinish(asyncProgram, glcShaderValidate) ? GLC_ASYNC_READY : GLC_ASYNC_FAILED, std::memory_order_relaxed);
+		glcAsyncProgramRecord(asyncProgram);
+		break;
+	}
+}
+
+// Returns the status without blocking. Once no longer pending, the status
+// and logs have been checked and the shaders deleted
+GLCAsyncStatus glcPollProgram(GLCShaderCompiler *compiler, GLCAsyncProgram *asyncProgram)
+{
+	const int status = asyncProgram->status.load(std::memory_order_acquire);
+
+	if (status != GLC_ASYNC_PENDING)
+		glcAsyncProgramRecord(asyncProgram);
+
+	if ((status != GLC_ASYNC_PENDING) || (compiler->mode != GLC_COMPILE_PARALLEL))
+		return (GLCAsyncStatus) status;
+
+	GLint completed = GL_FALSE;
+	glGetProgramiv(asyncProgram->program, GL_COMPLETION_STATUS_KHR, &completed);
+
+	if (!completed)
+		return GLC_ASYNC_PENDING;
+
+	const GLCAsyncStatus finished = glcAsyncProgramFinish(asyncProgram, glcShaderValidate) ? GLC_ASYNC_READY : GLC_ASYNC_FAILED;
+	asyncProgram->status.store(finished, std::memory_order_relaxed);
+
+	glcAsyncProgramRecord(asyncProgram);
+
+	return finished;
+}
+
+// Blocks until the program is done, returns GLC_NULL_HANDLE if it failed
+GLuint glcWaitProgram(GLCShaderCompiler *compiler, GLCAsyncProgram *asyncProgram)
+{
+	if (compiler->mode == GLC_COMPILE_PARALLEL)
+	{
+		// Querying anything besides the completion status blocks until linking is done
+		if (asyncProgram->status.load(std::memory_order_relaxed) == GLC_ASYNC_PENDING)
+			asyncProgram->status.store(glcAsyncProgramFinish(asyncProgram, glcShaderValidate) ? GLC_ASYNC_READY : GLC_ASYNC_FAILED, std::memory_order_relaxed);
+	}
+	else if (compiler->mode == GLC_COMPILE_WORKER)
+	{
+		std::unique_lock<std::mutex> lock(compiler->mutex);
+
+		compiler->finished.wait(lock, [asyncProgram]()
+		{
+			return asyncProgram->status.load(std::memory_order_acquire) != GLC_ASYNC_PENDING;
+		});
+	}
+
+	glcAsyncProgramRecord(asyncProgram);
+
+	return (asyncProgram->status.load(std::memory_order_acquire) == GLC_ASYNC_READY) ? asyncProgram->program : GLC_NULL_HANDLE;
+}
+
+#endif
@@ -0,0 +1,522 @@
+#ifndef GLC_SHADER_INCLUDE_H
+#define GLC_SHADER_INCLUDE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "shader.h"
+
+#define GLC_INCLUDE_PATH_LENGTH 256
+#define GLC_INCLUDE_MAX_DEPTH   32
+
+// Every file is read and parsed once into pieces, which point into the
+// file's contents. Resolving a shader only collects pointers to the pieces
+typedef enum GLCIncludePieceType
+{
+	GLC_INCLUDE_PIECE_TEXT,
+	GLC_INCLUDE_PIECE_INCLUDE,
+	GLC_INCLUDE_PIECE_LINE,
+} GLCIncludePieceType;
+
+typedef struct GLCIncludePiece
+{
+	GLCIncludePieceType type;
+
+	// GLC_INCLUDE_PIECE_TEXT
+	const char *text;
+	GLint length;
+
+	// GLC_INCLUDE_PIECE_INCLUDE, the index of the included fragment, or -1
+	// if it could not be loaded
+	int fragment;
+
+	// GLC_INCLUDE_PIECE_LINE, and after an include to resume the line numbering
+	char line[40];
+} GLCIncludePiece;
+
+typedef struct GLCIncludeFragment
+{
+	char path[GLC_INCLUDE_PATH_LENGTH];
+	char *source;
+
+	// Emitted before the fragment when it is included rather than compiled
+	char startLine[24];
+
+	GLCIncludePiece *pieces;
+	int pieceCount;
+} GLCIncludeFragment;
+
+// Fragment indices double as the source string numbers in #line directives,
+// such that compile logs read "<fragment>(<line>)"
+typedef struct GLCIncludeCacheStats
+{
+	// Files read and parsed, and loads served by an already parsed fragment
+	unsigned int reads, hits;
+} GLCIncludeCacheStats;
+
+typedef struct GLCIncludeCache
+{
+	GLCIncludeFragment *fragments;
+	int fragmentCount, fragmentCapacity;
+
+	GLCIncludeCacheStats stats;
+} GLCIncludeCache;
+
+typedef struct GLCIncludeSources
+{
+	const GLchar **strings;
+	GLint *lengths;
+	int count, capacity;
+
+	// Fragments already included, such that every file is included once
+	uint8_t *included;
+} GLCIncludeSources;
+
+void glcIncludeCacheInit(GLCIncludeCache *cache)
+{
+	memset(cache, 0, sizeof(GLCIncludeCache));
+}
+
+// The cache behind glcCreateShaderFromFile and the shader watcher
+GLCIncludeCache* glcGetIncludeCache()
+{
+	static GLCIncludeCache cache = { NULL, 0, 0, { 0, 0 } };
+
+	return &cache;
+}
+
+void glcIncludeFragmentFree(GLCIncludeFragment *fragment)
+{
+	free(fragment->source);
+	free(fragment->pieces);
+
+	fragment->source = NULL;
+	fragment->pieces = NULL;
+	fragment->pieceCount = 0;
+}
+
+void glcIncludeCacheDestroy(GLCIncludeCache *cache)
+{
+	for (int i = 0; i < cache->fragmentCount; ++i)
+		glcIncludeFragmentFree(cache->fragments + i);
+
+	free(cache->fragments);
+
+	memset(cache, 0, sizeof(GLCIncludeCache));
+}
+
+const char* glcIncludeCacheGetPath(const GLCIncludeCache *cache, int fragment)
+{
+	return ((fragment >= 0) && (fragment < cache->fragmentCount)) ? cache->fragments[fragment].path : "";
+}
+
+// Joins an include path onto the directory of the including file
+void glcIncludeResolvePath(char *path, size_t size, const char *includer, const char *include, size_t includeLength)
+{
+	const char *separator = strrchr(includer, '/');
+
+	if (separator && (include[0] != '/'))
+		snprintf(path, size, "%.*s/%.*s", (int) (separator - includer), includer, (int) includeLength, include);
+	else
+		snprintf(path, size, "%.*s", (int) includeLength, include);
+}
+
+int glcIncludeAddPiece(GLCIncludeFragment *fragment, int *capacity, const GLCIncludePiece *piece)
+{
+	if (fragment->pieceCount == *capacity)
+	{
+		const int newCapacity = *capacity ? (*capacity * 2) : 8;
+
+		GLCIncludePiece *pieces = (GLCIncludePiece*) realloc(fragment->pieces, newCapacity * sizeof(GLCIncludePiece));
+
+		if (!pieces)
+			return 0;
+
+		fragment->pieces = pieces;
+		*capacity = newCapacity;
+	}
+
+	fragment->pieces[fragment->pieceCount++] = *piece;
+
+	return 1;
+}
+
+int glcIncludeCacheLoad(GLCIncludeCache *cache, const char *path, int depth);
+
+// Splits the source at #include and #version lines. Includes inside block
+// comments are ignored
+int glcIncludeParse(GLCIncludeCache *cache, int index, int depth)
+{
+	int capacity = 0;
+
+	GLCIncludePiece piece;
+	memset(&piece, 0, sizeof(piece));
+
+	const char *text = cache->fragments[index].source;
+	const char *textStart = text;
+
+	int lineNumber = 1;
+	int inComment = 0;
+	int hasVersion = 0;
+
+	snprintf(cache->fragments[index].startLine, sizeof(cache->fragments[index].startLine), "#line 1 %d\n", index);
+
+	while (*text)
+	{
+		const char *lineStart = text;
+		const char *lineEnd = strchr(text, '\n');
+
+		if (!lineEnd)
+			lineEnd = text + strlen(text);
+
+		const char *c = lineStart;
+
+		while ((c < lineEnd) && ((*c == ' ') || (*c == '\t')))
+			++c;
+
+		int directive = 0;
+
+		if (!inComment && (*c == '#'))
+		{
+			++c;
+
+			while ((c < lineEnd) && ((*c == ' ') || (*c == '\t')))
+				++c;
+
+			if (strncmp(c, "include", 7) == 0)
+				directive = GLC_INCLUDE_PIECE_INCLUDE;
+			else if (strncmp(c, "version", 7) == 0)
+				directive = GLC_INCLUDE_PIECE_LINE;
+		}
+
+		for (const char *s = lineStart; (s + 1) < lineEnd; ++s)
+		{
+			if (!inComment && (s[0] == '/') && (s[1] == '/'))
+				break;
+
+			if (!inComment && (s[0] == '/') && (s[1] == '*'))
+				inComment = 1, ++s;
+			else if (inComment && (s[0] == '*') && (s[1] == '/'))
+				inComment = 0, ++s;
+		}
+
+		const char *next = *lineEnd ? (lineEnd + 1) : lineEnd;
+
+		if (directive == GLC_INCLUDE_PIECE_INCLUDE)
+		{
+			const char *open = strchr(c, '"');
+			const char *close = (open && (open < lineEnd)) ? strchr(open + 1, '"') : NULL;
+
+			if (!close || (close > lineEnd))
+			{
+				fprintf(stderr, "%s:%d: Malformed #include\n", cache->fragments[index].path, lineNumber);
+				return 0;
+			}
+
+			memset(&piece, 0, sizeof(piece));
+			piece.type = GLC_INCLUDE_PIECE_TEXT;
+			piece.text = textStart;
+			piece.length = (GLint) (lineStart - textStart);
+
+			if ((piece.length > 0) && !glcIncludeAddPiece(cache->fragments + index, &capacity, &piece))
+				return 0;
+
+			char includePath[GLC_INCLUDE_PATH_LENGTH];
+			glcIncludeResolvePath(includePath, sizeof(includePath), cache->fragments[index].path, open + 1, (size_t) (close - open - 1));
+
+			// Loading may reallocate the fragments
+			const int included = glcIncludeCacheLoad(cache, includePath, depth + 1);
+
+			if (included < 0)
+			{
+				fprintf(stderr, "%s:%d: Failed including \"%s\"\n", cache->fragments[index].path, lineNumber, includePath);
+				return 0;
+			}
+
+			memset(&piece, 0, sizeof(piece));
+			piece.type = GLC_INCLUDE_PIECE_INCLUDE;
+			piece.fragment = included;
+			snprintf(piece.line, sizeof(piece.line), "\n#line %d %d\n", lineNumber + 1, index);
+
+			if (!glcIncludeAddPiece(cache->fragments + index, &capacity, &piece))
+				return 0;
+
+			textStart = next;
+		}
+		else if ((directive == GLC_INCLUDE_PIECE_LINE) && !hasVersion)
+		{
+			// #version must come first, so the root file's numbering starts after it
+			hasVersion = 1;
+
+			memset(&piece, 0, sizeof(piece));
+			piece.type = GLC_INCLUDE_PIECE_TEXT;
+			piece.text = textStart;
+			piece.length = (GLint) (next - textStart);
+
+			if (!glcIncludeAddPiece(cache->fragments + index, &capacity, &piece))
+				return 0;
+
+			memset(&piece, 0, sizeof(piece));
+			piece.type = GLC_INCLUDE_PIECE_LINE;
+			snprintf(piece.line, sizeof(piece.line), "%s#line %d %d\n", *lineEnd ? "" : "\n", lineNumber + 1, index);
+
+			if (!glcIncludeAddPiece(cache->fragments + index, &capacity, &piece))
+				return 0;
+
+			textStart = next;
+		}
+
+		text = next;
+		++lineNumber;
+	}
+
+	memset(&piece, 0, sizeof(piece));
+	piece.type = GLC_INCLUDE_PIECE_TEXT;
+	piece.text = textStart;
+	piece.length = (GLint) (text - textStart);
+
+	if ((piece.length > 0) && !glcIncludeAddPiece(cache->fragments + index, &capacity, &piece))
+		return 0;
+
+	return 1;
+}
+
+// Returns the index of the fragment, reading and parsing the file if it is
+// not cached yet, or -1 on failure
+int glcIncludeCacheLoad(GLCIncludeCache *cache, const char *path, int depth = 0)
+{
+	for (int i = 0; i < cache->fragmentCount; ++i)
+	{
+		if (strcmp(cache->fragments[i].path, path) != 0)
+			continue;
+
+		if (!cache->fragments[i].source)
+			return -1;
+
+		++cache->stats.hits;
+
+		return i;
+	}
+
+	if (depth > GLC_INCLUDE_MAX_DEPTH)
+		return -1;
+
+	if (cache->fragmentCount == cache->fragmentCapacity)
+	{
+		const int capacity = cache->fragmentCapacity ? (cache->fragmentCapacity * 2) : 16;
+
+		GLCIncludeFragment *fragments = (GLCIncludeFragment*) realloc(cache->fragments, capacity * sizeof(GLCIncludeFragment));
+
+		if (!fragments)
+			return -1;
+
+		cache->fragments = fragments;
+		cache->fragmentCapacity = capacity;
+	}
+
+	const int index = cache->fragmentCount++;
+
+	GLCIncludeFragment *fragment = cache->fragments + index;
+	memset(fragment, 0, sizeof(GLCIncludeFragment));
+
+	snprintf(fragment->path, sizeof(fragment->path), "%s", path);
+	fragment->source = glcReadFile(path);
+
+	++cache->stats.reads;
+
+	if (!fragment->source)
+		return -1;
+
+	// Include cycles find the entry above instead of reading the file again,
+	// and are broken when resolving, as every file is included once
+	if (!glcIncludeParse(cache, index, depth))
+	{
+		glcIncludeFragmentFree(cache->fragments + index);
+		return -1;
+	}
+
+	return index;
+}
+
+// Drops the cached contents of a changed file, it is read again on next use.
+// Files including it keep pointing to its index, so they stay valid
+void glcIncludeCacheInvalidate(GLCIncludeCache *cache, const char *path)
+{
+	for (int i = 0; i < cache->fragmentCount; ++i)
+	{
+		if (strcmp(cache->fragments[i].path, path) != 0)
+			continue;
+
+		glcIncludeFragmentFree(cache->fragments + i);
+
+		// Invalidated files changed on disk
+		cache->fragments[i].source = glcReadFileFromDisk(path);
+
+		++cache->stats.reads;
+
+		if (cache->fragments[i].source && !glcIncludeParse(cache, i, 0))
+			glcIncludeFragmentFree(cache->fragments + i);
+	}
+}
+
+int glcIncludeSourcesAdd(GLCIncludeSources *sources, const GLchar *string, GLint length)
+{
+	if (sources->count == sources->capacity)
+	{
+		const int capacity = sources->capacity ? (sources->capacity * 2) : 32;
+
+		const GLchar **strings = (const GLchar**) realloc(sources->strings, capacity * sizeof(const GLchar*));
+		if (strings)
+			sources->strings = strings;
+
+		GLint *lengths = (GLint*) realloc(sources->lengths, capacity * sizeof(GLint));
+		if (lengths)
+			sources->lengths = lengths;
+
+		if (!strings || !lengths)
+			return 0;
+
+		sources->capacity = capacity;
+	}
+
+	sources->strings[sources->count] = string;
+	sources->lengths[sources->count] = length;
+	++sources->count;
+
+	return 1;
+}
+
+int glcIncludeCollect(const GLCIncludeCache *cache, int index, GLCIncludeSources *sources)
+{
+	const GLCIncludeFragment *fragment = cache->fragments + index;
+
+	if (!fragment->source)
+		return 0;
+
+	sources->included[index] = 1;
+
+	for (int i = 0; i < fragment->pieceCount; ++i)
+	{
+		const GLCIncludePiece *piece = fragment->pieces + i;
+
+		switch (piece->type)
+		{
+		case GLC_INCLUDE_PIECE_TEXT:
+			if (!glcIncludeSourcesAdd(sources, piece->text, piece->length))
+				return 0;
+			break;
+
+		case GLC_INCLUDE_PIECE_LINE:
+			if (!glcIncludeSourcesAdd(sources, piece->line, -1))
+				return 0;
+			break;
+
+		case GLC_INCLUDE_PIECE_INCLUDE:
+			// Acts as an include guard, and breaks include cycles
+			if (!sources->included[piece->fragment])
+			{
+				if (!glcIncludeSourcesAdd(sources, cache->fragments[piece->fragment].startLine, -1))
+					return 0;
+
+				if (!glcIncludeCollect(cache, piece->fragment, sources))
+					return 0;
+			}
+
+			// Skipped includes still remove their line
+			if (!glcIncludeSourcesAdd(sources, piece->line, -1))
+				return 0;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+void glcIncludeSourcesDestroy(GLCIncludeSources *sources)
+{
+	free(sources->strings);
+	free(sources->lengths);
+	free(sources->included);
+
+	memset(sources, 0, sizeof(GLCIncludeSources));
+}
+
+// Collects the strings of the file and everything it includes, pointing
+// into the cache. Returns 0 on failure
+int glcIncludeResolve(GLCIncludeCache *cache, const char *path, GLCIncludeSources *sources)
+{
+	memset(sources, 0, sizeof(GLCIncludeSources));
+
+	const int index = glcIncludeCacheLoad(cache, path);
+
+	if (index < 0)
+		return 0;
+
+	sources->included = (uint8_t*) calloc(cache->fragmentCount, sizeof(uint8_t));
+
+	if (!sources->included || !glcIncludeCollect(cache, index, sources))
+	{
+		glcIncludeSourcesDestroy(sources);
+		return 0;
+	}
+
+	return 1;
+}
+
+// Compiles the file, resolving #include "path" relative to the including
+// file. The strings are passed to glShaderSource as is. Resolving is
+// profiled as an include event, sized by the resolved source
+GLuint glcCreateShaderFromFileIncludes(GLCIncludeCache *cache, GLenum type, const char *filename)
+{
+	const double start = glcShaderProfileBegin();
+
+	GLCIncludeSources sources;
+
+	if (!glcIncludeResolve(cache, filename, &sources))
+	{
+		glcShaderProfileRecord(GLC_SHADER_EVENT_INCLUDE, type, GLC_NULL_HANDLE, 0, 0, start);
+		return GLC_NULL_HANDLE;
+	}
+
+	if (glcGetShaderProfile()->enabled)
+	{
+		size_t sourceSize = 0;
+
+		for (int i = 0; i < sources.count; ++i)
+			sourceSize += (sources.lengths[i] >= 0) ? (size_t) sources.lengths[i] : strlen(sources.strings[i]);
+
+		glcShaderProfileRecord(GLC_SHADER_EVENT_INCLUDE, type, GLC_NULL_HANDLE, sourceSize, 1, start);
+	}
+
+	const GLuint shader = glcCreateShaderSources(type, sources.count, sources.strings, sources.lengths);
+
+	if (shader == GLC_NULL_HANDLE)
+	{
+		// Logs refer to files by their fragment index
+		for (int i = 0; i < cache->fragmentCount; ++i)
+		{
+			if (sources.included[i])
+				printf("  %d: %s\n", i, cache->fragments[i].path);
+		}
+	}
+
+	glcIncludeSourcesDestroy(&sources);
+
+	return shader;
+}
+
+// Embedded files are used if there are any, see glcReadFile
+GLuint glcCreateShaderFromFile(GLenum type, const char *filename)
+{
+	return glcCreateShaderFromFileIncludes(glcGetIncludeCache(), type, filename);
+}
+
+void glcIncludeCachePrintStats(const GLCIncludeCache *cache)
+{
+	printf("Include Cache: %d files, %u reads, %u hits\n", cache->fragmentCount, cache->stats.reads, cache->stats.hits);
+}
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef GLC_SHADER_PROFILE_H
+#define GLC_SHADER_PROFILE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+
+// Recording is off unless enabled here or with glcShaderProfileEnable
+#ifndef GLC_SHADER_PROFILE
+#	define GLC_SHADER_PROFILE 0
+#endif
+
+typedef enum GLCShaderEventKind
+{
+	GLC_SHADER_EVENT_COMPILE,
+	GLC_SHADER_EVENT_LINK,
+	GLC_SHADER_EVENT_VALIDATE,
+	GLC_SHADER_EVENT_CACHE_LOAD,
+
+	// Loading and resolving #include, before the compile
+	GLC_SHADER_EVENT_INCLUDE,
+
+	// Compiling and linking a program from shader_async.h, which overlaps
+	// other work and is left out of the total
+	GLC_SHADER_EVENT_ASYNC_BUILD,
+
+	GLC_SHADER_EVENT_KIND_COUNT
+} GLCShaderEventKind;
+
+typedef enum GLCShaderCacheStatus
+{
+	// Not built through the program cache
+	GLC_SHADER_CACHE_NONE,
+
+	GLC_SHADER_CACHE_HIT,
+	GLC_SHADER_CACHE_MISS
+} GLCShaderCacheStatus;
+
+typedef struct GLCShaderEvent
+{
+	GLCShaderEventKind kind;
+
+	// The stage for compiles, 0 for programs
+	GLenum shaderType;
+	GLuint object;
+
+	size_t sourceSize;
+
+	GLCShaderCacheStatus cacheStatus;
+	int success;
+
+	// Seconds, start relative to when profiling was enabled
+	double start, duration;
+} GLCShaderEvent;
+
+// Only touched on the main thread. shader_async.h times builds wherever they
+// happen, and adds the events once they are done
+typedef struct GLCShaderProfile
+{
+	int enabled;
+
+	GLCShaderEvent *events;
+	size_t count, capacity;
+
+	// Attached to the events recorded until changed, set by the program cache
+	GLCShaderCacheStatus cacheStatus;
+
+	double origin;
+} GLCShaderProfile;
+
+const char* glcGetShaderTypeString(GLenum type);
+
+GLCShaderProfile* glcGetShaderProfile()
+{
+	static GLCShaderProfile profile = { GLC_SHADER_PROFILE, NULL, 0, 0, GLC_SHADER_CACHE_NONE, 0.0 };
+
+	return &profile;
+}
+
+void glcShaderProfileEnable(int enabled)
+{
+	GLCShaderProfile *profile = glcGetShaderProfile();
+
+	if (enabled && !profile->enabled && !profile->count)
+		profile->origin = glfwGetTime();
+
+	profile->enabled = enabled;
+}
+
+void glcShaderProfileReset()
+{
+	GLCShaderProfile *profile = glcGetShaderProfile();
+
+	free(profile->events);
+
+	profile->events = NULL;
+	profile->count = profile->capacity = 0;
+	profile->origin = glfwGetTime();
+}
+
+// Returns the time to pass to glcShaderProfileRecord, 0 if not profiling,
+// such that disabled profiling costs nothing but the check
+double glcShaderProfileBegin()
+{
+	return glcGetShaderProfile()->enabled ? glfwGetTime() : 0.0;
+}
+
+// Adds an event timed elsewhere, with start in glfwGetTime seconds. Added
+// even if profiling was disabled since, as the caller decides
+void glcShaderProfileAppend(const GLCShaderEvent *event)
+{
+	GLCShaderProfile *profile = glcGetShaderProfile();
+
+	if (profile->count == profile->capacity)
+	{
+		const size_t capacity = profile->capacity ? (profile->capacity * 2) : 64;
+		GLCShaderEvent *events = (GLCShaderEvent*) realloc(profile->events, capacity * sizeof(GLCShaderEvent));
+
+		if (!events)
+			return;
+
+		profile->events = events;
+		profile->capacity = capacity;
+	}
+
+	GLCShaderEvent *appended = profile->events + profile->count++;
+
+	*appended = *event;
+	appended->start = event->start - profile->origin;
+}
+
+void glcShaderProfileRecord(GLCShaderEventKind kind, GLenum shaderType, GLuint object, size_t sourceSize, int success, double start)
+{
+	GLCShaderProfile *profile = glcGetShaderProfile();
+
+	if (!profile->enabled)
+		return;
+
+	GLCShaderEvent event;
+
+	event.kind = kind;
+	event.shaderType = shaderType;
+	event.object = object;
+	event.sourceSize = sourceSize;
+	event.cacheStatus = profile->cacheStatus;
+	event.success = success;
+	event.start = start;
+	event.duration = glfwGetTime() - start;
+
+	glcShaderProfileAppend(&event);
+}
+
+const char* glcGetShaderEventKindString(GLCShaderEventKind kind)
+{
+	switch (kind)
+	{
+	case GLC_SHADER_EVENT_COMPILE:
+		return "Compile";
+	case GLC_SHADER_EVENT_LINK:
+		return "Link";
+	case GLC_SHADER_EVENT_VALIDATE:
+		return "Validate";
+	case GLC_SHADER_EVENT_CACHE_LOAD:
+		return "CacheLoad";
+	case GLC_SHADER_EVENT_INCLUDE:
+		return "Include";
+	case GLC_SHADER_EVENT_ASYNC_BUILD:
+		return "AsyncBuild";
+	default:
+		return "Unknown";
+	}
+}
+
+const char* glcGetShaderCacheStatusString(GLCShaderCacheStatus status)
+{
+	switch (status)
+	{
+	case GLC_SHADER_CACHE_HIT:
+		return "hit";
+	case GLC_SHADER_CACHE_MISS:
+		return "miss";
+	default:
+		return "none";
+	}
+}
+
+int glcShaderEventCompare(const void *a, const void *b)
+{
+	const double durationA = ((const GLCShaderEvent*) a)->duration;
+	const double durationB = ((const GLCShaderEvent*) b)->duration;
+
+	return (durationA < durationB) - (durationA > durationB);
+}
+
+// Prints the totals per kind, and the most expensive events first, all of
+// them if limit is 0
+void glcShaderProfilePrint(size_t limit = 20)
+{
+	const GLCShaderProfile *profile = glcGetShaderProfile();
+
+	double totals[GLC_SHADER_EVENT_KIND_COUNT] = { 0.0 };
+	size_t counts[GLC_SHADER_EVENT_KIND_COUNT] = { 0 };
+
+	double total = 0.0;
+
+	for (size_t i = 0; i < profile->count; ++i)
+	{
+		totals[profile->events[i].kind] += profile->events[i].duration;
+		++counts[profile->events[i].kind];
+
+		if (profile->events[i].kind != GLC_SHADER_EVENT_ASYNC_BUILD)
+			total += profile->events[i].duration;
+	}
+
+	printf("Shader Build: %.3f ms in %zu events\n", total * 1000.0, profile->count);
+
+	for (int kind = 0; kind < GLC_SHADER_EVENT_KIND_COUNT; ++kind)
+	{
+		printf("  %-10s %4zu %10.3f ms", glcGetShaderEventKindString((GLCShaderEventKind) kind), counts[kind], totals[kind] * 1000.0);
+
+		if (kind == GLC_SHADER_EVENT_ASYNC_BUILD)
+			printf("   async\n");
+		else
+			printf(" %5.1f%%\n", (total > 0.0) ? (totals[kind] / total * 100.0) : 0.0);
+	}
+
+	if (!profile->count)
+		return;
+
+	GLCShaderEvent *sorted = (GLCShaderEvent*) malloc(profile->count * sizeof(GLCShaderEvent));
+
+	if (!sorted)
+		return;
+
+	memcpy(sorted, profile->events, profile->count * sizeof(GLCShaderEvent));
+	qsort(sorted, profile->count, sizeof(GLCShaderEvent), glcShaderEventCompare);
+
+	const size_t count = (limit && (limit < profile->count)) ? limit : profile->count;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const GLCShaderEvent *event = sorted + i;
+
+		printf("  %10.3f ms %-10s %-10s %5u %8zu bytes cache=%s%s\n", event->duration * 1000.0,
+		       glcGetShaderEventKindString(event->kind), event->shaderType ? glcGetShaderTypeString(event->shaderType) : "Program",
+		       event->object, event->sourceSize, glcGetShaderCacheStatusString(event->cacheStatus), event->success ? "" : " FAILED");
+	}
+
+	free(sorted);
+}
+
+// Writes the events in the Chrome trace event format, which can be opened
+// in chrome://tracing or Perfetto. Returns 0 on failure
+int glcShaderProfileWriteTrace(const char *path)
+{
+	const GLCShaderProfile *profile = glcGetShaderProfile();
+
+	FILE *f = fopen(path, "w");
+
+	if (!f)
+		return 0;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	for (size_t i = 0; i < profile->count; ++i)
+	{
+		const GLCShaderEvent *event = profile->events + i;
+
+		fprintf(f, "{\"name\":\"%s %s\",\"cat\":\"shader\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+		        "\"args\":{\"object\":%u,\"sourceSize\":%zu,\"cache\":\"%s\",\"success\":%d}}%s\n",
+		        glcGetShaderEventKindString(event->kind), event->shaderType ? glcGetShaderTypeString(event->shaderType) : "Program",
+		        (event->kind == GLC_SHADER_EVENT_ASYNC_BUILD) ? 2 : 1, event->start * 1000000.0, event->duration * 1000000.0,
+		        event->object, event->sourceSize, glcGetShaderCacheStatusString(event->cacheStatus), event->success,
+		        (i + 1 < profile->count) ? "," : "");
+	}
+
+	fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+
+	const int written = !ferror(f);
+
+	fclose(f);
+
+	return written;
+}
+
+#endif
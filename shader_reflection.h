@@ -0,0 +1,425 @@
+#ifndef GLC_SHADER_REFLECTION_H
+#define GLC_SHADER_REFLECTION_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gl.h"
+
+#define GLC_INVALID_NAME 0
+
+// Names are interned into small dense IDs once, such that lookups hash an
+// integer instead of a string. The pool is global and not thread-safe
+typedef struct GLCNamePool
+{
+	char **names;
+	uint32_t *hashes;
+	uint32_t count, capacity;
+
+	// Open addressing, holds IDs with 0 marking an empty slot
+	uint32_t *table;
+	uint32_t tableMask;
+} GLCNamePool;
+
+GLCNamePool* glcGetNamePool()
+{
+	static GLCNamePool pool = { NULL, NULL, 0, 0, NULL, 0 };
+	return &pool;
+}
+
+// 32-bit FNV-1a
+uint32_t glcHashName(const char *name, size_t length)
+{
+	uint32_t hash = 0x811C9DC5u;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= (unsigned char) name[i];
+		hash *= 0x01000193u;
+	}
+
+	return hash;
+}
+
+int glcNamePoolGrow(GLCNamePool *pool)
+{
+	const uint32_t capacity = pool->capacity ? (pool->capacity * 2) : 64;
+
+	char **names = (char**) realloc(pool->names, (capacity + 1) * sizeof(char*));
+	if (names)
+		pool->names = names;
+
+	uint32_t *hashes = (uint32_t*) realloc(pool->hashes, (capacity + 1) * sizeof(uint32_t));
+	if (hashes)
+		pool->hashes = hashes;
+
+	// Twice the capacity keeps the load factor at or below 50%
+	uint32_t *table = (uint32_t*) calloc(capacity * 2, sizeof(uint32_t));
+
+	if (!names || !hashes || !table)
+	{
+		free(table);
+		return 0;
+	}
+
+	const uint32_t tableMask = capacity * 2 - 1;
+
+	for (uint32_t id = 1; id <= pool->count; ++id)
+	{
+		uint32_t slot = pool->hashes[id] & tableMask;
+
+		while (table[slot])
+			slot = (slot + 1) & tableMask;
+
+		table[slot] = id;
+	}
+
+	free(pool->table);
+
+	pool->table = table;
+	pool->tableMask = tableMask;
+	pool->capacity = capacity;
+
+	return 1;
+}
+
+// Returns the ID of the name, interning it if it is new. IDs start at 1
+uint32_t glcInternNameLength(const char *name, size_t length)
+{
+	GLCNamePool *pool = glcGetNamePool();
+
+	const uint32_t hash = glcHashName(name, length);
+
+	if (pool->table)
+	{
+		for (uint32_t slot = hash & pool->tableMask; pool->table[slot]; slot = (slot + 1) & pool->tableMask)
+		{
+			const uint32_t id = pool->table[slot];
+
+			if ((pool->hashes[id] == hash) && (strncmp(pool->names[id], name, length) == 0) && (pool->names[id][length] == '\0'))
+				return id;
+		}
+	}
+
+	if ((pool->count == pool->capacity) && !glcNamePoolGrow(pool))
+		return GLC_INVALID_NAME;
+
+	char *copy = (char*) malloc(length + 1);
+
+	if (!copy)
+		return GLC_INVALID_NAME;
+
+	memcpy(copy, name, length);
+	copy[length] = '\0';
+
+	const uint32_t id = ++pool->count;
+
+	pool->names[id] = copy;
+	pool->hashes[id] = hash;
+
+	uint32_t slot = hash & pool->tableMask;
+
+	while (pool->table[slot])
+		slot = (slot + 1) & pool->tableMask;
+
+	pool->table[slot] = id;
+
+	return id;
+}
+
+uint32_t glcInternName(const char *name)
+{
+	return glcInternNameLength(name, strlen(name));
+}
+
+const char* glcGetName(uint32_t id)
+{
+	const GLCNamePool *pool = glcGetNamePool();
+	return ((id != GLC_INVALID_NAME) && (id <= pool->count)) ? pool->names[id] : "";
+}
+
+typedef enum GLCReflectionKind
+{
+	GLC_REFLECTION_UNIFORM,
+	GLC_REFLECTION_ATTRIBUTE,
+	GLC_REFLECTION_UNIFORM_BLOCK,
+	GLC_REFLECTION_KIND_COUNT,
+} GLCReflectionKind;
+
+typedef struct GLCUniformInfo
+{
+	uint32_t nameID;
+	GLenum type;
+	GLint size;
+
+	// -1 for uniforms in blocks, which are described by the block index and layout
+	GLint location;
+
+	GLint blockIndex;
+	GLint offset, arrayStride, matrixStride;
+} GLCUniformInfo;
+
+typedef struct GLCAttributeInfo
+{
+	uint32_t nameID;
+	GLenum type;
+	GLint size;
+	GLint location;
+} GLCAttributeInfo;
+
+typedef struct GLCUniformBlockInfo
+{
+	uint32_t nameID;
+	GLuint index;
+	GLint dataSize;
+	GLint binding;
+	GLint uniformCount;
+} GLCUniformBlockInfo;
+
+typedef struct GLCReflectionEntry
+{
+	uint32_t nameID;
+	uint16_t kind;
+	uint16_t index;
+} GLCReflectionEntry;
+
+// Everything active in a linked program, queried once. Lookups by name ID
+// never call into GL
+typedef struct GLCProgramReflection
+{
+	GLuint program;
+
+	GLCUniformInfo *uniforms;
+	GLCAttributeInfo *attributes;
+	GLCUniformBlockInfo *blocks;
+	GLint uniformCount, attributeCount, blockCount;
+
+	// Open addressing, keyed by name ID and kind
+	GLCReflectionEntry *table;
+	uint32_t tableMask;
+} GLCProgramReflection;
+
+uint32_t glcReflectionSlot(uint32_t nameID, uint32_t kind, uint32_t tableMask)
+{
+	// Name IDs are dense, multiplying spreads neighbouring IDs across the table
+	return ((nameID * 3 + kind) * 0x9E3779B1u) & tableMask;
+}
+
+void glcReflectionInsert(GLCProgramReflection *reflection, uint32_t nameID, GLCReflectionKind kind, int index)
+{
+	uint32_t slot = glcReflectionSlot(nameID, kind, reflection->tableMask);
+
+	while (reflection->table[slot].nameID != GLC_INVALID_NAME)
+	{
+		// Array uniforms are inserted both as "name[0]" and "name"
+		if ((reflection->table[slot].nameID == nameID) && (reflection->table[slot].kind == kind))
+			return;
+
+		slot = (slot + 1) & reflection->tableMask;
+	}
+
+	reflection->table[slot].nameID = nameID;
+	reflection->table[slot].kind = (uint16_t) kind;
+	reflection->table[slot].index = (uint16_t) index;
+}
+
+// Interns the name, and if it ends in "[0]" also the name without it
+uint32_t glcReflectionInternArrayName(GLCProgramReflection *reflection, const char *name, GLsizei length, GLCReflectionKind kind, int index)
+{
+	const uint32_t nameID = glcInternNameLength(name, (size_t) length);
+	glcReflectionInsert(reflection, nameID, kind, index);
+
+	if ((length > 3) && (strcmp(name + length - 3, "[0]") == 0))
+		glcReflectionInsert(reflection, glcInternNameLength(name, (size_t) (length - 3)), kind, index);
+
+	return nameID;
+}
+
+void glcReflectionDestroy(GLCProgramReflection *reflection)
+{
+	free(reflection->uniforms);
+	free(reflection->attributes);
+	free(reflection->blocks);
+	free(reflection->table);
+
+	memset(reflection, 0, sizeof(GLCProgramReflection));
+}
+
+// Queries all active uniforms, attributes and uniform blocks of a linked
+// program. Returns 0 on failure
+int glcReflectProgram(GLCProgramReflection *reflection, GLuint program)
+{
+	memset(reflection, 0, sizeof(GLCProgramReflection));
+
+	reflection->program = program;
+
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &reflection->uniformCount);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &reflection->attributeCount);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &reflection->blockCount);
+
+	GLint uniformNameLength = 0, attributeNameLength = 0, blockNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformNameLength);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attributeNameLength);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &blockNameLength);
+
+	GLint maxNameLength = uniformNameLength;
+	if (attributeNameLength > maxNameLength)
+		maxNameLength = attributeNameLength;
+	if (blockNameLength > maxNameLength)
+		maxNameLength = blockNameLength;
+
+	// Each array uniform takes up to two entries, sized to at most 50% load
+	const uint32_t entryCount = (uint32_t) (reflection->uniformCount * 2 + reflection->attributeCount + reflection->blockCount);
+	uint32_t tableSize = 16;
+
+	while (tableSize < (entryCount * 2))
+		tableSize *= 2;
+
+	reflection->uniforms = (GLCUniformInfo*) calloc(reflection->uniformCount + 1, sizeof(GLCUniformInfo));
+	reflection->attributes = (GLCAttributeInfo*) calloc(reflection->attributeCount + 1, sizeof(GLCAttributeInfo));
+	reflection->blocks = (GLCUniformBlockInfo*) calloc(reflection->blockCount + 1, sizeof(GLCUniformBlockInfo));
+	reflection->table = (GLCReflectionEntry*) calloc(tableSize, sizeof(GLCReflectionEntry));
+	reflection->tableMask = tableSize - 1;
+
+	GLchar *name = (GLchar*) malloc((size_t) maxNameLength + 1);
+
+	if (!reflection->uniforms || !reflection->attributes || !reflection->blocks || !reflection->table || !name)
+	{
+		free(name);
+		glcReflectionDestroy(reflection);
+
+		return 0;
+	}
+
+	for (GLint i = 0; i < reflection->uniformCount; ++i)
+	{
+		GLCUniformInfo *uniform = reflection->uniforms + i;
+
+		GLsizei length = 0;
+		glGetActiveUniform(program, (GLuint) i, maxNameLength + 1, &length, &uniform->size, &uniform->type, name);
+
+		uniform->nameID = glcReflectionInternArrayName(reflection, name, length, GLC_REFLECTION_UNIFORM, i);
+		uniform->location = glGetUniformLocation(program, name);
+	}
+
+	// Block layouts for all uniforms at once, -1 for uniforms in the default block
+	if (reflection->uniformCount > 0)
+	{
+		GLuint *indices = (GLuint*) malloc(reflection->uniformCount * sizeof(GLuint));
+		GLint *values = (GLint*) malloc(reflection->uniformCount * sizeof(GLint));
+
+		if (indices && values)
+		{
+			for (GLint i = 0; i < reflection->uniformCount; ++i)
+				indices[i] = (GLuint) i;
+
+			static const GLenum parameters[] = { GL_UNIFORM_BLOCK_INDEX, GL_UNIFORM_OFFSET, GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_MATRIX_STRIDE };
+			const size_t fields[] = {
+					offsetof(GLCUniformInfo, blockIndex), offsetof(GLCUniformInfo, offset),
+					offsetof(GLCUniformInfo, arrayStride), offsetof(GLCUniformInfo, matrixStride),
+			};
+
+			for (size_t p = 0; p < sizeof(parameters) / sizeof(*parameters); ++p)
+			{
+				glGetActiveUniformsiv(program, reflection->uniformCount, indices, parameters[p], values);
+
+				for (GLint i = 0; i < reflection->uniformCount; ++i)
+					*(GLint*) ((char*) (reflection->uniforms + i) + fields[p]) = values[i];
+			}
+		}
+
+		free(values);
+		free(indices);
+	}
+
+	for (GLint i = 0; i < reflection->attributeCount; ++i)
+	{
+		GLCAttributeInfo *attribute = reflection->attributes + i;
+
+		GLsizei length = 0;
+		glGetActiveAttrib(program, (GLuint) i, maxNameLength + 1, &length, &attribute->size, &attribute->type, name);
+
+		attribute->nameID = glcReflectionInternArrayName(reflection, name, length, GLC_REFLECTION_ATTRIBUTE, i);
+		attribute->location = glGetAttribLocation(program, name);
+	}
+
+	for (GLint i = 0; i < reflection->blockCount; ++i)
+	{
+		GLCUniformBlockInfo *block = reflection->blocks + i;
+
+		GLsizei length = 0;
+		glGetActiveUniformBlockName(program, (GLuint) i, maxNameLength + 1, &length, name);
+
+		block->nameID = glcReflectionInternArrayName(reflection, name, length, GLC_REFLECTION_UNIFORM_BLOCK, i);
+		block->index = (GLuint) i;
+
+		glGetActiveUniformBlockiv(program, (GLuint) i, GL_UNIFORM_BLOCK_DATA_SIZE, &block->dataSize);
+		glGetActiveUniformBlockiv(program, (GLuint) i, GL_UNIFORM_BLOCK_BINDING, &block->binding);
+		glGetActiveUniformBlockiv(program, (GLuint) i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &block->uniformCount);
+	}
+
+	free(name);
+
+	return 1;
+}
+
+// Returns the index into the kind's array, or -1 if it is not active
+int glcReflectionFind(const GLCProgramReflection *reflection, uint32_t nameID, GLCReflectionKind kind)
+{
+	if (!reflection->table)
+		return -1;
+
+	for (uint32_t slot = glcReflectionSlot(nameID, kind, reflection->tableMask);
+	     reflection->table[slot].nameID != GLC_INVALID_NAME;
+	     slot = (slot + 1) & reflection->tableMask)
+	{
+		if ((reflection->table[slot].nameID == nameID) && (reflection->table[slot].kind == kind))
+			return reflection->table[slot].index;
+	}
+
+	return -1;
+}
+
+const GLCUniformInfo* glcReflectionGetUniform(const GLCProgramReflection *reflection, uint32_t nameID)
+{
+	const int index = glcReflectionFind(reflection, nameID, GLC_REFLECTION_UNIFORM);
+	return (index >= 0) ? (reflection->uniforms + index) : NULL;
+}
+
+const GLCAttributeInfo* glcReflectionGetAttribute(const GLCProgramReflection *reflection, uint32_t nameID)
+{
+	const int index = glcReflectionFind(reflection, nameID, GLC_REFLECTION_ATTRIBUTE);
+	return (index >= 0) ? (reflection->attributes + index) : NULL;
+}
+
+const GLCUniformBlockInfo* glcReflectionGetUniformBlock(const GLCProgramReflection *reflection, uint32_t nameID)
+{
+	const int index = glcReflectionFind(reflection, nameID, GLC_REFLECTION_UNIFORM_BLOCK);
+	return (index >= 0) ? (reflection->blocks + index) : NULL;
+}
+
+// -1 if not active, like glGetUniformLocation
+GLint glcReflectionGetUniformLocation(const GLCProgramReflection *reflection, uint32_t nameID)
+{
+	const int index = glcReflectionFind(reflection, nameID, GLC_REFLECTION_UNIFORM);
+	return (index >= 0) ? reflection->uniforms[index].location : -1;
+}
+
+// -1 if not active, like glGetAttribLocation
+GLint glcReflectionGetAttribLocation(const GLCProgramReflection *reflection, uint32_t nameID)
+{
+	const int index = glcReflectionFind(reflection, nameID, GLC_REFLECTION_ATTRIBUTE);
+	return (index >= 0) ? reflection->attributes[index].location : -1;
+}
+
+// Resolves the uniform locations of a fixed list of names once, such that
+// setting them per draw only indexes locations[slot]
+void glcReflectionResolveUniformSlots(const GLCProgramReflection *reflection, const uint32_t *nameIDs, GLint *locations, size_t count)
+{
+	for (size_t slot = 0; slot < count; ++slot)
+		locations[slot] = glcReflectionGetUniformLocation(reflection, nameIDs[slot]);
+}
+
+#endif
@@ -0,0 +1,511 @@
+#ifndef GLC_SHADER_RELOAD_H
+#define GLC_SHADER_RELOAD_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#	include <fcntl.h>
+#	include <errno.h>
+#endif
+
+#include "gl.h"
+#include "shader.h"
+#include "shader_include.h"
+
+#define GLC_WATCH_MAX_FILES       64
+#define GLC_WATCH_MAX_PROGRAMS    32
+#define GLC_WATCH_MAX_DIRECTORIES 16
+#define GLC_WATCH_PATH_LENGTH     256
+
+#define GLC_WATCH_STAGE_COUNT 3
+
+typedef struct GLCWatchedFile
+{
+	char path[GLC_WATCH_PATH_LENGTH];
+
+	// Points into path, which is what inotify reports relative to the directory
+	const char *name;
+	int directory;
+
+	// GL_NONE for files that are only included
+	GLenum type;
+
+	// The last shader that compiled, kept such that programs only recompile changed stages
+	GLuint shader;
+
+	// A bit per watched file this one includes, directly or not
+	uint64_t includes;
+
+	// Seconds since the epoch, for the latency from saving to swapping
+	double modified;
+	int dirty;
+} GLCWatchedFile;
+
+typedef struct GLCWatchedProgram
+{
+	int files[GLC_WATCH_STAGE_COUNT];
+
+	GLuint program;
+
+	// Incremented on every swap, such that users can tell when to requery locations
+	unsigned int generation;
+} GLCWatchedProgram;
+
+typedef struct GLCReloadStats
+{
+	unsigned int reloads, failures;
+
+	// Milliseconds from noticing a change, and from the file being saved, until swapping
+	double lastLatency, maxLatency, totalLatency;
+	double lastSaveLatency;
+} GLCReloadStats;
+
+typedef struct GLCShaderWatcher
+{
+	int fd;
+
+	char directories[GLC_WATCH_MAX_DIRECTORIES][GLC_WATCH_PATH_LENGTH];
+	int directoryWatches[GLC_WATCH_MAX_DIRECTORIES];
+	int directoryCount;
+
+	GLCWatchedFile files[GLC_WATCH_MAX_FILES];
+	int fileCount;
+
+	GLCWatchedProgram programs[GLC_WATCH_MAX_PROGRAMS];
+	int programCount;
+
+	GLCReloadStats stats;
+} GLCShaderWatcher;
+
+double glcGetWallTime()
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+
+	return (double) now.tv_sec + (double) now.tv_nsec * 1.0e-9;
+}
+
+// Returns 0 if the file does not exist
+double glcGetModifiedTime(const char *path)
+{
+	struct stat info;
+
+	if (stat(path, &info) != 0)
+		return 0.0;
+
+#ifdef __linux__
+	return (double) info.st_mtim.tv_sec + (double) info.st_mtim.tv_nsec * 1.0e-9;
+#else
+	return (double) info.st_mtime;
+#endif
+}
+
+// Without inotify, changes are found by polling modification times
+int glcShaderWatcherInit(GLCShaderWatcher *watcher)
+{
+	memset(watcher, 0, sizeof(GLCShaderWatcher));
+
+	watcher->fd = -1;
+
+#ifdef __linux__
+	watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (watcher->fd < 0)
+	{
+		fprintf(stderr, "Failed initializing inotify, falling back to polling\n");
+		return 0;
+	}
+#endif
+
+	return 1;
+}
+
+void glcShaderWatcherDestroy(GLCShaderWatcher *watcher)
+{
+	for (int i = 0; i < watcher->programCount; ++i)
+	{
+		if (watcher->programs[i].program != GLC_NULL_HANDLE)
+			glDeleteProgram(watcher->programs[i].program);
+	}
+
+	for (int i = 0; i < watcher->fileCount; ++i)
+	{
+		if (watcher->files[i].shader != GLC_NULL_HANDLE)
+			glDeleteShader(watcher->files[i].shader);
+	}
+
+#ifdef __linux__
+	if (watcher->fd >= 0)
+		close(watcher->fd);
+#endif
+
+	memset(watcher, 0, sizeof(GLCShaderWatcher));
+
+	watcher->fd = -1;
+}
+
+// Editors commonly save by writing a new file and renaming it over the old
+// one, so directories are watched rather than the files themselves
+int glcShaderWatcherAddDirectory(GLCShaderWatcher *watcher, const char *directory)
+{
+	for (int i = 0; i < watcher->directoryCount; ++i)
+	{
+		if (strcmp(watcher->directories[i], directory) == 0)
+			return i;
+	}
+
+	if (watcher->directoryCount == GLC_WATCH_MAX_DIRECTORIES)
+		return -1;
+
+	const int index = watcher->directoryCount++;
+
+	snprintf(watcher->directories[index], GLC_WATCH_PATH_LENGTH, "%s", directory);
+	watcher->directoryWatches[index] = -1;
+
+#ifdef __linux__
+	if (watcher->fd >= 0)
+		watcher->directoryWatches[index] = inotify_add_watch(watcher->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+#endif
+
+	return index;
+}
+
+// Returns the index of the file, watching its directory, or -1 if there
+// is no room left
+int glcShaderWatcherAddPath(GLCShaderWatcher *watcher, GLenum type, const char *path)
+{
+	for (int i = 0; i < watcher->fileCount; ++i)
+	{
+		if ((watcher->files[i].type == type) && (strcmp(watcher->files[i].path, path) == 0))
+			return i;
+	}
+
+	if (watcher->fileCount == GLC_WATCH_MAX_FILES)
+		return -1;
+
+	GLCWatchedFile *file = watcher->files + watcher->fileCount;
+	memset(file, 0, sizeof(GLCWatchedFile));
+
+	snprintf(file->path, GLC_WATCH_PATH_LENGTH, "%s", path);
+
+	const char *separator = strrchr(file->path, '/');
+
+	if (separator)
+	{
+		char directory[GLC_WATCH_PATH_LENGTH];
+		snprintf(directory, sizeof(directory), "%.*s", (int) (separator - file->path), file->path);
+
+		file->directory = glcShaderWatcherAddDirectory(watcher, directory);
+		file->name = separator + 1;
+	}
+	else
+	{
+		file->directory = glcShaderWatcherAddDirectory(watcher, ".");
+		file->name = file->path;
+	}
+
+	file->type = type;
+	file->modified = glcGetModifiedTime(path);
+
+	return watcher->fileCount++;
+}
+
+// Watches every file the shader includes, such that editing one recompiles
+// the shader. Done after every compile, as the includes may have changed
+void glcShaderWatcherTrackIncludes(GLCShaderWatcher *watcher, int index)
+{
+	GLCIncludeCache *cache = glcGetIncludeCache();
+	GLCIncludeSources sources;
+
+	watcher->files[index].includes = 0;
+
+	if (!glcIncludeResolve(cache, watcher->files[index].path, &sources))
+		return;
+
+	for (int i = 0; i < cache->fragmentCount; ++i)
+	{
+		const char *path = glcIncludeCacheGetPath(cache, i);
+
+		if (!sources.included[i] || (strcmp(path, watcher->files[index].path) == 0))
+			continue;
+
+		const int include = glcShaderWatcherAddPath(watcher, GL_NONE, path);
+
+		if (include >= 0)
+			watcher->files[index].includes |= (uint64_t) 1 << include;
+		else
+			fprintf(stderr, "Too many watched files, edits to %s are not noticed\n", path);
+	}
+
+	glcIncludeSourcesDestroy(&sources);
+}
+
+// Returns the index of the file, compiling it if it is not watched yet
+int glcShaderWatcherAddFile(GLCShaderWatcher *watcher, GLenum type, const char *path)
+{
+	for (int i = 0; i < watcher->fileCount; ++i)
+	{
+		if ((watcher->files[i].type == type) && (strcmp(watcher->files[i].path, path) == 0))
+			return i;
+	}
+
+	const GLuint shader = glcCreateShaderFromFile(type, path);
+
+	if (shader == GLC_NULL_HANDLE)
+		return -1;
+
+	const int index = glcShaderWatcherAddPath(watcher, type, path);
+
+	if (index < 0)
+	{
+		glDeleteShader(shader);
+		return -1;
+	}
+
+	watcher->files[index].shader = shader;
+
+	glcShaderWatcherTrackIncludes(watcher, index);
+
+	return index;
+}
+
+// Returns an ID for glcGetWatchedProgram, or -1 on failure
+int glcWatchProgram(GLCShaderWatcher *watcher, const char *vertexPath, const char *fragmentPath, const char *geometryPath = NULL)
+{
+	if (watcher->programCount == GLC_WATCH_MAX_PROGRAMS)
+		return -1;
+
+	GLCWatchedProgram *watched = watcher->programs + watcher->programCount;
+
+	watched->files[0] = glcShaderWatcherAddFile(watcher, GL_VERTEX_SHADER, vertexPath);
+	watched->files[1] = glcShaderWatcherAddFile(watcher, GL_FRAGMENT_SHADER, fragmentPath);
+	watched->files[2] = geometryPath ? glcShaderWatcherAddFile(watcher, GL_GEOMETRY_SHADER, geometryPath) : -1;
+
+	if ((watched->files[0] < 0) || (watched->files[1] < 0) || (geometryPath && (watched->files[2] < 0)))
+		return -1;
+
+	const GLuint geometryShader = (watched->files[2] >= 0) ? watcher->files[watched->files[2]].shader : GLC_NULL_HANDLE;
+
+	watched->program = glcCreateProgram(watcher->files[watched->files[0]].shader, watcher->files[watched->files[1]].shader, geometryShader);
+	watched->generation = 0;
+
+	if (watched->program == GLC_NULL_HANDLE)
+		return -1;
+
+	return watcher->programCount++;
+}
+
+GLuint glcGetWatchedProgram(const GLCShaderWatcher *watcher, int id)
+{
+	return watcher->programs[id].program;
+}
+
+unsigned int glcGetWatchedProgramGeneration(const GLCShaderWatcher *watcher, int id)
+{
+	return watcher->programs[id].generation;
+}
+
+// Marks files changed since the last call dirty, returns the number of dirty files
+int glcShaderWatcherPoll(GLCShaderWatcher *watcher)
+{
+#ifdef __linux__
+	if (watcher->fd >= 0)
+	{
+		alignas(struct inotify_event) char buffer[4096];
+
+		for (;;)
+		{
+			const ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+
+			if (length <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const struct inotify_event *event = (const struct inotify_event*) (buffer + offset);
+				offset += (ssize_t) (sizeof(struct inotify_event) + event->len);
+
+				// Events were dropped, so any file may have changed
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					for (int i = 0; i < watcher->fileCount; ++i)
+						watcher->files[i].dirty = 1;
+
+					continue;
+				}
+
+				if (event->len == 0)
+					continue;
+
+				for (int i = 0; i < watcher->fileCount; ++i)
+				{
+					GLCWatchedFile *file = watcher->files + i;
+
+					if ((watcher->directoryWatches[file->directory] == event->wd) && (strcmp(file->name, event->name) == 0))
+						file->dirty = 1;
+				}
+			}
+		}
+
+		int dirtyCount = 0;
+
+		for (int i = 0; i < watcher->fileCount; ++i)
+		{
+			if (watcher->files[i].dirty)
+			{
+				watcher->files[i].modified = glcGetModifiedTime(watcher->files[i].path);
+				++dirtyCount;
+			}
+		}
+
+		return dirtyCount;
+	}
+#endif
+
+	int dirtyCount = 0;
+
+	for (int i = 0; i < watcher->fileCount; ++i)
+	{
+		GLCWatchedFile *file = watcher->files + i;
+
+		const double modified = glcGetModifiedTime(file->path);
+
+		if ((modified != 0.0) && (modified != file->modified))
+		{
+			file->modified = modified;
+			file->dirty = 1;
+		}
+
+		dirtyCount += file->dirty;
+	}
+
+	return dirtyCount;
+}
+
+// Call between frames. Recompiles changed files, relinks the programs using
+// them and swaps in the new programs. Anything that fails to compile or link
+// keeps the last good version. Returns the number of swapped programs
+int glcShaderWatcherUpdate(GLCShaderWatcher *watcher)
+{
+	if (glcShaderWatcherPoll(watcher) == 0)
+		return 0;
+
+	const double start = glfwGetTime();
+
+	int compiled[GLC_WATCH_MAX_FILES];
+	double newestSave = 0.0;
+
+	uint64_t changed = 0;
+
+	// The files changed on disk, so the cached and embedded copies are out of date
+	for (int i = 0; i < watcher->fileCount; ++i)
+	{
+		GLCWatchedFile *file = watcher->files + i;
+
+		if (!file->dirty)
+			continue;
+
+		file->dirty = 0;
+		changed |= (uint64_t) 1 << i;
+
+		if (file->modified > newestSave)
+			newestSave = file->modified;
+
+		glcIncludeCacheInvalidate(glcGetIncludeCache(), file->path);
+	}
+
+	// Files added while tracking includes are only included, never compiled
+	const int fileCount = watcher->fileCount;
+
+	for (int i = 0; i < fileCount; ++i)
+	{
+		GLCWatchedFile *file = watcher->files + i;
+
+		compiled[i] = 0;
+
+		const uint64_t stale = changed & (((uint64_t) 1 << i) | file->includes);
+
+		if ((file->type == GL_NONE) || !stale)
+			continue;
+
+		const GLuint shader = glcCreateShaderFromFile(file->type, file->path);
+
+		if (shader == GLC_NULL_HANDLE)
+		{
+			fprintf(stderr, "Failed reloading %s, keeping the last good version\n", file->path);
+			++watcher->stats.failures;
+			continue;
+		}
+
+		glDeleteShader(file->shader);
+		file->shader = shader;
+
+		glcShaderWatcherTrackIncludes(watcher, i);
+
+		compiled[i] = 1;
+	}
+
+	int swapped = 0;
+
+	for (int p = 0; p < watcher->programCount; ++p)
+	{
+		GLCWatchedProgram *watched = watcher->programs + p;
+
+		int affected = 0;
+
+		for (int s = 0; s < GLC_WATCH_STAGE_COUNT; ++s)
+			affected |= (watched->files[s] >= 0) && compiled[watched->files[s]];
+
+		if (!affected)
+			continue;
+
+		const GLuint geometryShader = (watched->files[2] >= 0) ? watcher->files[watched->files[2]].shader : GLC_NULL_HANDLE;
+		const GLuint program = glcCreateProgram(watcher->files[watched->files[0]].shader, watcher->files[watched->files[1]].shader, geometryShader);
+
+		if (program == GLC_NULL_HANDLE)
+		{
+			fprintf(stderr, "Failed relinking program %d, keeping the last good version\n", p);
+			++watcher->stats.failures;
+			continue;
+		}
+
+		glDeleteProgram(watched->program);
+
+		watched->program = program;
+		++watched->generation;
+
+		++swapped;
+	}
+
+	if (swapped > 0)
+	{
+		const double latency = (glfwGetTime() - start) * 1000.0;
+
+		GLCReloadStats *stats = &watcher->stats;
+
+		stats->reloads += (unsigned int) swapped;
+		stats->lastLatency = latency;
+		stats->totalLatency += latency;
+
+		if (latency > stats->maxLatency)
+			stats->maxLatency = latency;
+
+		// Includes the time until the next frame noticed the change
+		stats->lastSaveLatency = (newestSave > 0.0) ? ((glcGetWallTime() - newestSave) * 1000.0) : 0.0;
+
+		printf("Reloaded %d program(s) in %.2f ms, %.2f ms after saving (%u reloads, %u failures, %.2f ms max)\n",
+		       swapped, latency, stats->lastSaveLatency, stats->reloads, stats->failures, stats->maxLatency);
+	}
+
+	return swapped;
+}
+
+#endif
@@ -0,0 +1,371 @@
+#ifndef GLC_SHADER_VARIANTS_H
+#define GLC_SHADER_VARIANTS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "shader.h"
+#include "shader_async.h"
+
+#define GLC_VARIANT_MAX_FEATURES 32
+#define GLC_VARIANT_STAGE_COUNT  3
+
+// Bit i enables the i-th feature
+typedef uint32_t GLCVariantKey;
+
+typedef struct GLCVariantEntry
+{
+	GLCVariantKey key;
+	int used;
+
+	GLuint program;
+	GLCAsyncStatus status;
+
+	// Only while compiling asynchronously
+	GLCAsyncProgram *async;
+} GLCVariantEntry;
+
+typedef struct GLCShaderVariantStats
+{
+	unsigned int compiled, failed, pending;
+} GLCShaderVariantStats;
+
+// Variants of one program differing by #defines. Nothing is compiled until
+// a variant is first requested
+typedef struct GLCShaderVariants
+{
+	// Each source split after its #version line, where the defines go
+	char *sources[GLC_VARIANT_STAGE_COUNT];
+	size_t headerLengths[GLC_VARIANT_STAGE_COUNT];
+
+	char *defines[GLC_VARIANT_MAX_FEATURES];
+	int featureCount;
+
+	// Compiles asynchronously if set
+	GLCShaderCompiler *compiler;
+
+	// Open addressing, keyed by the variant key
+	GLCVariantEntry *entries;
+	uint32_t entryCount, entryMask;
+
+	GLCShaderVariantStats stats;
+} GLCShaderVariants;
+
+char* glcVariantCopyString(const char *str)
+{
+	const size_t length = strlen(str);
+	char *copy = (char*) malloc(length + 1);
+
+	if (copy)
+		memcpy(copy, str, length + 1);
+
+	return copy;
+}
+
+// Length up to and including the #version line, or 0 if there is none
+size_t glcVariantHeaderLength(const char *source)
+{
+	const char *version = strstr(source, "#version");
+
+	if (!version)
+		return 0;
+
+	const char *lineEnd = strchr(version, '\n');
+
+	return lineEnd ? (size_t) (lineEnd + 1 - source) : strlen(source);
+}
+
+void glcShaderVariantsDestroy(GLCShaderVariants *variants);
+
+// features are the names of the defines, in key bit order. geometrySource
+// may be NULL. compiler enables asynchronous compiling, and may be NULL
+int glcShaderVariantsInit(GLCShaderVariants *variants, const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource,
+                          const char *const *features, int featureCount, GLCShaderCompiler *compiler = NULL)
+{
+	memset(variants, 0, sizeof(GLCShaderVariants));
+
+	if (featureCount > GLC_VARIANT_MAX_FEATURES)
+		return 0;
+
+	const GLchar *sources[GLC_VARIANT_STAGE_COUNT] = { vertexSource, fragmentSource, geometrySource };
+
+	for (int i = 0; i < GLC_VARIANT_STAGE_COUNT; ++i)
+	{
+		if (!sources[i])
+			continue;
+
+		variants->sources[i] = glcVariantCopyString(sources[i]);
+		variants->headerLengths[i] = glcVariantHeaderLength(sources[i]);
+
+		if (!variants->sources[i])
+		{
+			glcShaderVariantsDestroy(variants);
+			return 0;
+		}
+	}
+
+	for (int i = 0; i < featureCount; ++i)
+	{
+		const size_t length = strlen(features[i]) + sizeof("#define  1\n");
+
+		variants->defines[i] = (char*) malloc(length);
+
+		if (!variants->defines[i])
+		{
+			glcShaderVariantsDestroy(variants);
+			return 0;
+		}
+
+		snprintf(variants->defines[i], length, "#define %s 1\n", features[i]);
+	}
+
+	variants->featureCount = featureCount;
+	variants->compiler = compiler;
+
+	return 1;
+}
+
+void glcShaderVariantsDestroy(GLCShaderVariants *variants)
+{
+	for (uint32_t i = 0; variants->entries && (i <= variants->entryMask); ++i)
+	{
+		GLCVariantEntry *entry = variants->entries + i;
+
+		if (!entry->used)
+			continue;
+
+		// The worker may still be using it
+		if (entry->async && variants->compiler)
+			entry->program = glcWaitProgram(variants->compiler, entry->async);
+
+		delete entry->async;
+
+		if (entry->program != GLC_NULL_HANDLE)
+			glDeleteProgram(entry->program);
+	}
+
+	free(variants->entries);
+
+	for (int i = 0; i < GLC_VARIANT_STAGE_COUNT; ++i)
+		free(variants->sources[i]);
+
+	for (int i = 0; i < GLC_VARIANT_MAX_FEATURES; ++i)
+		free(variants->defines[i]);
+
+	memset(variants, 0, sizeof(GLCShaderVariants));
+}
+
+// Returns the bit of the named feature, or 0 if there is no such feature
+GLCVariantKey glcShaderVariantKey(const GLCShaderVariants *variants, const char *feature)
+{
+	const size_t length = strlen(feature);
+
+	for (int i = 0; i < variants->featureCount; ++i)
+	{
+		// Skips "#define "
+		const char *name = variants->defines[i] + 8;
+
+		if ((strncmp(name, feature, length) == 0) && (name[length] == ' '))
+			return (GLCVariantKey) 1 << i;
+	}
+
+	return 0;
+}
+
+// The stage's source with the enabled defines inserted after #version, and
+// a #line directive keeping log line numbers matching the original source
+char* glcShaderVariantSource(const GLCShaderVariants *variants, int stage, GLCVariantKey key)
+{
+	const char *source = variants->sources[stage];
+	const size_t headerLength = variants->headerLengths[stage];
+
+	int headerLines = 0;
+
+	for (size_t i = 0; i < headerLength; ++i)
+		headerLines += source[i] == '\n';
+
+	char line[24];
+	snprintf(line, sizeof(line), "#line %d\n", headerLines + 1);
+
+	size_t length = strlen(source) + strlen(line);
+
+	for (int i = 0; i < variants->featureCount; ++i)
+	{
+		if (key & ((GLCVariantKey) 1 << i))
+			length += strlen(variants->defines[i]);
+	}
+
+	char *result = (char*) malloc(length + 1);
+
+	if (!result)
+		return NULL;
+
+	char *end = result;
+
+	memcpy(end, source, headerLength);
+	end += headerLength;
+
+	for (int i = 0; i < variants->featureCount; ++i)
+	{
+		if (key & ((GLCVariantKey) 1 << i))
+		{
+			const size_t defineLength = strlen(variants->defines[i]);
+
+			memcpy(end, variants->defines[i], defineLength);
+			end += defineLength;
+		}
+	}
+
+	memcpy(end, line, strlen(line));
+	end += strlen(line);
+
+	strcpy(end, source + headerLength);
+
+	return result;
+}
+
+uint32_t glcVariantSlot(GLCVariantKey key, uint32_t mask)
+{
+	return (key * 0x9E3779B1u) & mask;
+}
+
+// Returns the entry for the key, inserting an unused one if needed
+GLCVariantEntry* glcShaderVariantFind(GLCShaderVariants *variants, GLCVariantKey key)
+{
+	// Grows at 50% load, the few variants actually used stay cheap to probe
+	if ((variants->entryCount + 1) * 2 > (variants->entries ? (variants->entryMask + 1) : 0))
+	{
+		const uint32_t capacity = variants->entries ? ((variants->entryMask + 1) * 2) : 16;
+
+		GLCVariantEntry *entries = (GLCVariantEntry*) calloc(capacity, sizeof(GLCVariantEntry));
+
+		if (!entries)
+			return NULL;
+
+		for (uint32_t i = 0; variants->entries && (i <= variants->entryMask); ++i)
+		{
+			if (!variants->entries[i].used)
+				continue;
+
+			uint32_t slot = glcVariantSlot(variants->entries[i].key, capacity - 1);
+
+			while (entries[slot].used)
+				slot = (slot + 1) & (capacity - 1);
+
+			entries[slot] = variants->entries[i];
+		}
+
+		free(variants->entries);
+
+		variants->entries = entries;
+		variants->entryMask = capacity - 1;
+	}
+
+	uint32_t slot = glcVariantSlot(key, variants->entryMask);
+
+	while (variants->entries[slot].used && (variants->entries[slot].key != key))
+		slot = (slot + 1) & variants->entryMask;
+
+	return variants->entries + slot;
+}
+
+// Returns the variant's program, compiling it on first use. While compiling
+// asynchronously this returns GLC_NULL_HANDLE, such that callers can skip
+// drawing or fall back to another variant. Failed variants are not retried
+GLuint glcGetShaderVariant(GLCShaderVariants *variants, GLCVariantKey key)
+{
+	key &= (variants->featureCount < 32) ? (((GLCVariantKey) 1 << variants->featureCount) - 1) : ~(GLCVariantKey) 0;
+
+	GLCVariantEntry *entry = glcShaderVariantFind(variants, key);
+
+	if (!entry)
+		return GLC_NULL_HANDLE;
+
+	if (entry->used)
+	{
+		if ((entry->status == GLC_ASYNC_PENDING) && entry->async)
+		{
+			entry->status = glcPollProgram(variants->compiler, entry->async);
+
+			if (entry->status != GLC_ASYNC_PENDING)
+			{
+				entry->program = entry->async->program;
+
+				delete entry->async;
+				entry->async = NULL;
+
+				--variants->stats.pending;
+
+				if (entry->status == GLC_ASYNC_READY)
+					++variants->stats.compiled;
+				else
+					++variants->stats.failed;
+			}
+		}
+
+		return (entry->status == GLC_ASYNC_READY) ? entry->program : GLC_NULL_HANDLE;
+	}
+
+	entry->used = 1;
+	entry->key = key;
+	entry->program = GLC_NULL_HANDLE;
+	entry->async = NULL;
+
+	++variants->entryCount;
+
+	char *sources[GLC_VARIANT_STAGE_COUNT] = { NULL, NULL, NULL };
+	int valid = 1;
+
+	for (int i = 0; i < GLC_VARIANT_STAGE_COUNT; ++i)
+	{
+		if (variants->sources[i])
+		{
+			sources[i] = glcShaderVariantSource(variants, i, key);
+			valid &= sources[i] != NULL;
+		}
+	}
+
+	if (valid && variants->compiler)
+	{
+		entry->async = new GLCAsyncProgram;
+		entry->status = GLC_ASYNC_PENDING;
+
+		glcSubmitProgram(variants->compiler, entry->async, sources[0], sources[1], sources[2]);
+
+		++variants->stats.pending;
+	}
+	else
+	{
+		const GLuint vertexShader = valid ? glcCreateShader(GL_VERTEX_SHADER, sources[0]) : GLC_NULL_HANDLE;
+		const GLuint fragmentShader = valid ? glcCreateShader(GL_FRAGMENT_SHADER, sources[1]) : GLC_NULL_HANDLE;
+		const GLuint geometryShader = (valid && sources[2]) ? glcCreateShader(GL_GEOMETRY_SHADER, sources[2]) : GLC_NULL_HANDLE;
+
+		if ((vertexShader != GLC_NULL_HANDLE) && (fragmentShader != GLC_NULL_HANDLE) && (!sources[2] || (geometryShader != GLC_NULL_HANDLE)))
+			entry->program = glcCreateProgram(vertexShader, fragmentShader, geometryShader);
+
+		if (geometryShader != GLC_NULL_HANDLE)
+			glDeleteShader(geometryShader);
+		if (fragmentShader != GLC_NULL_HANDLE)
+			glDeleteShader(fragmentShader);
+		if (vertexShader != GLC_NULL_HANDLE)
+			glDeleteShader(vertexShader);
+
+		entry->status = (entry->program != GLC_NULL_HANDLE) ? GLC_ASYNC_READY : GLC_ASYNC_FAILED;
+
+		if (entry->status == GLC_ASYNC_READY)
+			++variants->stats.compiled;
+		else
+			++variants->stats.failed;
+	}
+
+	for (int i = 0; i < GLC_VARIANT_STAGE_COUNT; ++i)
+		free(sources[i]);
+
+	// Immediate mode compiles on submit
+	return glcGetShaderVariant(variants, key);
+}
+
+#endif
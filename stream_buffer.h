@@ -0,0 +1,319 @@
+#ifndef GLC_STREAM_BUFFER_H
+#define GLC_STREAM_BUFFER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "gl_state.h"
+
+#define GLC_STREAM_FRAME_COUNT  3
+#define GLC_STREAM_MAX_REGIONS  8
+
+// How long a single glClientWaitSync blocks before trying again
+#define GLC_STREAM_WAIT_TIMEOUT 1000000 // 1 ms
+
+typedef enum GLCStreamMode
+{
+	// Mapped once with glBufferStorage, written while the GPU reads other regions
+	GLC_STREAM_PERSISTENT,
+
+	// Each region mapped unsynchronized while written, fences keep it safe
+	GLC_STREAM_MAP_RANGE,
+
+	// The whole buffer orphaned every frame, the driver handles the rest
+	GLC_STREAM_ORPHAN
+} GLCStreamMode;
+
+typedef struct GLCStreamBufferStats
+{
+	// Frames that had to wait for the GPU to release their region
+	unsigned int waits;
+	double waitTime;
+} GLCStreamBufferStats;
+
+// A buffer split into a region per frame in flight. Data is written straight
+// into mapped memory, and each region is fenced after the frame using it
+typedef struct GLCStreamBuffer
+{
+	GLuint buffer;
+	GLenum target;
+
+	GLCStreamMode mode;
+
+	// The current region's memory from mappedStart on, while mapped
+	unsigned char *mapped;
+	size_t mappedStart;
+
+	// Set between glcStreamBufferBeginFrame and glcStreamBufferEndFrame
+	int active;
+
+	// The whole buffer, kept mapped in persistent mode
+	unsigned char *persistent;
+
+	size_t regionSize, offset;
+	int regionCount, region;
+
+	size_t alignment;
+
+	GLsync fences[GLC_STREAM_MAX_REGIONS];
+
+	GLCStreamBufferStats stats;
+} GLCStreamBuffer;
+
+const char* glcGetStreamModeString(GLCStreamMode mode)
+{
+	switch (mode)
+	{
+	case GLC_STREAM_PERSISTENT:
+		return "Persistent";
+	case GLC_STREAM_MAP_RANGE:
+		return "MapRange";
+	case GLC_STREAM_ORPHAN:
+		return "Orphan";
+	default:
+		return "Unknown";
+	}
+}
+
+// Binds through the state cache when given one, such that it stays in sync
+void glcStreamBufferBind(const GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	if (state)
+		glcStateBindBuffer(state, stream->target, stream->buffer);
+	else
+		glBindBuffer(stream->target, stream->buffer);
+}
+
+void glcStreamBufferDeleteBuffer(GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	if (state)
+		glcStateDeleteBuffers(state, 1, &stream->buffer);
+	else
+		glDeleteBuffers(1, &stream->buffer);
+
+	stream->buffer = GLC_NULL_HANDLE;
+}
+
+// Picks the best mode available unless mode is given, and falls back to
+// map range if the persistent mapping fails. state may be NULL, otherwise
+// every bind goes through it. alignment 0 uses the uniform buffer offset
+// alignment for uniform buffers, and 16 otherwise. Returns 0 on failure
+int glcStreamBufferCreate(GLCStreamBuffer *stream, GLCStateCache *state, GLenum target, size_t regionSize, int regionCount = GLC_STREAM_FRAME_COUNT,
+                          size_t alignment = 0, int mode = -1)
+{
+	memset(stream, 0, sizeof(GLCStreamBuffer));
+
+	if ((regionCount < 1) || (regionCount > GLC_STREAM_MAX_REGIONS))
+		return 0;
+
+	if (!alignment)
+	{
+		GLint uniformAlignment = 0;
+
+		if (target == GL_UNIFORM_BUFFER)
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+		alignment = (uniformAlignment > 16) ? (size_t) uniformAlignment : 16;
+	}
+
+	if (mode == -1)
+		mode = (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) ? GLC_STREAM_PERSISTENT : GLC_STREAM_MAP_RANGE;
+
+	if ((mode == GLC_STREAM_PERSISTENT) && !(GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage))
+		mode = GLC_STREAM_MAP_RANGE;
+
+	// Orphaning replaces the whole buffer every frame, so one region is enough
+	if (mode == GLC_STREAM_ORPHAN)
+		regionCount = 1;
+
+	stream->target = target;
+	stream->mode = (GLCStreamMode) mode;
+	stream->alignment = alignment;
+	stream->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+	stream->regionCount = regionCount;
+
+	// Starts at the last region, such that the first frame uses region 0
+	stream->region = regionCount - 1;
+
+	const GLsizeiptr size = (GLsizeiptr) (stream->regionSize * (size_t) regionCount);
+
+	glGenBuffers(1, &stream->buffer);
+	glcStreamBufferBind(stream, state);
+
+	if (stream->mode == GLC_STREAM_PERSISTENT)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(target, size, NULL, flags);
+		stream->persistent = (unsigned char*) glMapBufferRange(target, 0, size, flags);
+
+		if (stream->persistent)
+			return 1;
+
+		// Storage is immutable, so map range needs a buffer of its own
+		glcStreamBufferDeleteBuffer(stream, state);
+
+		stream->mode = GLC_STREAM_MAP_RANGE;
+
+		glGenBuffers(1, &stream->buffer);
+		glcStreamBufferBind(stream, state);
+	}
+
+	glBufferData(target, size, NULL, GL_STREAM_DRAW);
+
+	return 1;
+}
+
+void glcStreamBufferDestroy(GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	for (int i = 0; i < GLC_STREAM_MAX_REGIONS; ++i)
+	{
+		if (stream->fences[i])
+			glDeleteSync(stream->fences[i]);
+	}
+
+	if (stream->buffer != GLC_NULL_HANDLE)
+	{
+		if (stream->persistent || stream->mapped)
+		{
+			glcStreamBufferBind(stream, state);
+			glUnmapBuffer(stream->target);
+		}
+
+		glcStreamBufferDeleteBuffer(stream, state);
+	}
+
+	memset(stream, 0, sizeof(GLCStreamBuffer));
+}
+
+// Blocks until the GPU is done with the region's previous frame
+void glcStreamBufferWait(GLCStreamBuffer *stream, int region)
+{
+	GLsync fence = stream->fences[region];
+
+	if (!fence)
+		return;
+
+	GLenum result = glClientWaitSync(fence, 0, 0);
+
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		const double start = glfwGetTime();
+
+		++stream->stats.waits;
+
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLC_STREAM_WAIT_TIMEOUT);
+		}
+		while (result == GL_TIMEOUT_EXPIRED);
+
+		stream->stats.waitTime += glfwGetTime() - start;
+	}
+
+	glDeleteSync(fence);
+	stream->fences[region] = NULL;
+}
+
+size_t glcStreamBufferRegionStart(const GLCStreamBuffer *stream)
+{
+	return (stream->mode == GLC_STREAM_ORPHAN) ? 0 : (stream->regionSize * (size_t) stream->region);
+}
+
+// Maps the current region from start to its end
+int glcStreamBufferMap(GLCStreamBuffer *stream, GLCStateCache *state, size_t start)
+{
+	stream->mappedStart = start;
+
+	if (stream->mode == GLC_STREAM_PERSISTENT)
+	{
+		stream->mapped = stream->persistent + glcStreamBufferRegionStart(stream) + start;
+		return 1;
+	}
+
+	glcStreamBufferBind(stream, state);
+
+	// Either fenced or orphaned, the driver does not have to synchronize
+	stream->mapped = (unsigned char*) glMapBufferRange(stream->target, (GLintptr) (glcStreamBufferRegionStart(stream) + start), (GLsizeiptr) (stream->regionSize - start),
+	                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+	return stream->mapped != NULL;
+}
+
+// Moves on to the next region, waiting for the GPU if it is still reading
+// it. Returns 0 if the region could not be mapped
+int glcStreamBufferBeginFrame(GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	stream->region = (stream->region + 1) % stream->regionCount;
+	stream->offset = 0;
+	stream->active = 1;
+
+	glcStreamBufferWait(stream, stream->region);
+
+	if (stream->mode == GLC_STREAM_ORPHAN)
+	{
+		glcStreamBufferBind(stream, state);
+		glBufferData(stream->target, (GLsizeiptr) stream->regionSize, NULL, GL_STREAM_DRAW);
+	}
+
+	return glcStreamBufferMap(stream, state, 0);
+}
+
+// Returns memory for size bytes in the current region, and the buffer offset
+// of it, or NULL if the region is full. After a flush, the rest of the
+// region is mapped again
+void* glcStreamBufferAlloc(GLCStreamBuffer *stream, GLCStateCache *state, size_t size, GLintptr *offset)
+{
+	const size_t start = (stream->offset + stream->alignment - 1) / stream->alignment * stream->alignment;
+
+	if (!stream->active || ((start + size) > stream->regionSize))
+		return NULL;
+
+	if (!stream->mapped && !glcStreamBufferMap(stream, state, start))
+		return NULL;
+
+	stream->offset = start + size;
+
+	*offset = (GLintptr) (glcStreamBufferRegionStart(stream) + start);
+
+	return stream->mapped + (start - stream->mappedStart);
+}
+
+// Must be called after writing and before drawing with the data. Unmaps
+// the region, except for persistent mappings, which are coherent and stay
+// mapped
+void glcStreamBufferFlush(GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	if (!stream->mapped || (stream->mode == GLC_STREAM_PERSISTENT))
+		return;
+
+	glcStreamBufferBind(stream, state);
+	glUnmapBuffer(stream->target);
+
+	stream->mapped = NULL;
+}
+
+// Must be called after the last draw reading the region
+void glcStreamBufferEndFrame(GLCStreamBuffer *stream, GLCStateCache *state)
+{
+	glcStreamBufferFlush(stream, state);
+
+	stream->mapped = NULL;
+	stream->active = 0;
+
+	if (stream->mode == GLC_STREAM_ORPHAN)
+		return;
+
+	stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void glcStreamBufferPrintStats(const GLCStreamBuffer *stream)
+{
+	printf("Stream Buffer: %s, %d x %zu bytes, waited %u times (%.3f ms)\n", glcGetStreamModeString(stream->mode),
+	       stream->regionCount, stream->regionSize, stream->stats.waits, stream->stats.waitTime * 1000.0);
+}
+
+#endif
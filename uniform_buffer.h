@@ -0,0 +1,126 @@
+#ifndef GLC_UNIFORM_BUFFER_H
+#define GLC_UNIFORM_BUFFER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "gl.h"
+#include "shader_reflection.h"
+
+typedef struct GLCStd140Member
+{
+	GLenum type;
+
+	// 0 or 1 for non-arrays
+	GLint arraySize;
+
+	// Filled in by glcStd140Layout
+	size_t offset, arrayStride;
+} GLCStd140Member;
+
+// Base alignment and size of a non-array member, 0 for unsupported types.
+// Matrices are arrays of column vectors, each aligned like a vec4
+void glcStd140TypeLayout(GLenum type, size_t *alignment, size_t *size)
+{
+	switch (type)
+	{
+	case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+		*alignment = 4, *size = 4;
+		break;
+	case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2:
+		*alignment = 8, *size = 8;
+		break;
+	case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+		*alignment = 16, *size = 12;
+		break;
+	case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4:
+		*alignment = 16, *size = 16;
+		break;
+	case GL_FLOAT_MAT2:
+		*alignment = 16, *size = 2 * 16;
+		break;
+	case GL_FLOAT_MAT3:
+		*alignment = 16, *size = 3 * 16;
+		break;
+	case GL_FLOAT_MAT4:
+		*alignment = 16, *size = 4 * 16;
+		break;
+	default:
+		*alignment = 0, *size = 0;
+		break;
+	}
+}
+
+size_t glcAlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// Assigns std140 offsets to the members in order, returns the size of the
+// block, or 0 if a member has an unsupported type
+size_t glcStd140Layout(GLCStd140Member *members, int count)
+{
+	size_t offset = 0;
+
+	for (int i = 0; i < count; ++i)
+	{
+		size_t alignment, size;
+		glcStd140TypeLayout(members[i].type, &alignment, &size);
+
+		if (!alignment)
+			return 0;
+
+		if (members[i].arraySize > 1)
+		{
+			// Array elements are padded to the alignment of a vec4
+			alignment = glcAlignUp(alignment, 16);
+			members[i].arrayStride = glcAlignUp(size, 16);
+
+			size = members[i].arrayStride * (size_t) members[i].arraySize;
+		}
+		else
+		{
+			members[i].arrayStride = 0;
+		}
+
+		offset = glcAlignUp(offset, alignment);
+		members[i].offset = offset;
+
+		offset += size;
+	}
+
+	// A block is padded like a structure
+	return glcAlignUp(offset, 16);
+}
+
+// Assigns the block to the binding point, returns the block's size as laid
+// out by the driver, or 0 if the program has no such block
+GLint glcUniformBlockBind(const GLCProgramReflection *reflection, uint32_t blockNameID, GLuint binding)
+{
+	const GLCUniformBlockInfo *block = glcReflectionGetUniformBlock(reflection, blockNameID);
+
+	if (!block)
+		return 0;
+
+	glUniformBlockBinding(reflection->program, block->index, binding);
+
+	return block->dataSize;
+}
+
+// Copies data to the uniform's offset in block memory, using the offset the
+// driver reported. Returns 0 if the uniform is not in a block
+int glcUniformBlockWrite(void *blockData, const GLCProgramReflection *reflection, uint32_t uniformNameID, const void *data, size_t size)
+{
+	const GLCUniformInfo *uniform = glcReflectionGetUniform(reflection, uniformNameID);
+
+	if (!uniform || (uniform->blockIndex < 0) || (uniform->offset < 0))
+		return 0;
+
+	memcpy((char*) blockData + uniform->offset, data, size);
+
+	return 1;
+}
+
+#endif
@@ -1,13 +1,23 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
 
 #define LOADOBJ_IMPLEMENTATION
 #include <loadobj.h> // https://github.com/Vallentin/LoadOBJ
 
 #include "gl.h"
+#include "gl_state.h"
 #include "shader.h"
+#include "program_cache.h"
+#include "shader_reflection.h"
+#include "shader_reload.h"
+#include "uniform_buffer.h"
+#include "stream_buffer.h"
+#include "draw_queue.h"
+#include "mesh.h"
+#include "shader_interface.h"
 #include "linmath.h"
 #include "glfw_utilities.h"
 
@@ -43,6 +53,25 @@ char* loadFile(const char *filename)
 
 int main(int argc, char *argv[])
 {
+	const char *shaderTracePath = NULL;
+
+	// Picked from what the context supports, unless forced
+	int streamMode = -1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--shader-trace") == 0) && ((i + 1) < argc))
+			shaderTracePath = argv[++i];
+		else if (strcmp(argv[i], "--no-validate") == 0)
+			glcShaderValidate = 0;
+		else if (strcmp(argv[i], "--stream-persistent") == 0)
+			streamMode = GLC_STREAM_PERSISTENT;
+		else if (strcmp(argv[i], "--stream-map-range") == 0)
+			streamMode = GLC_STREAM_MAP_RANGE;
+		else if (strcmp(argv[i], "--stream-orphan") == 0)
+			streamMode = GLC_STREAM_ORPHAN;
+	}
+
 	if (!glfwInit())
 	{
 		fprintf(stderr, "Failed initializing GLFW\n");
@@ -81,7 +110,10 @@ int main(int argc, char *argv[])
 			"\n"
 			"out vec3 vNormal;\n"
 			"\n"
-			"uniform mat4 mvp;\n"
+			"layout(std140) uniform Transforms\n"
+			"{\n"
+			"    mat4 mvp;\n"
+			"};\n"
 			"\n"
 			"void main()\n"
 			"{\n"
@@ -101,32 +133,69 @@ int main(int argc, char *argv[])
 			"    fragColor = vec4(abs(vNormal), 1.0);\n"
 			"}\n";
 
-	const GLuint defaultVertexShader   = glcCreateShader(GL_VERTEX_SHADER, defaultVertexShaderSource);
-	const GLuint defaultFragmentShader = glcCreateShader(GL_FRAGMENT_SHADER, defaultFragmentShaderSource);
+	glcShaderProfileEnable(1);
 
-	if ((defaultVertexShader == GLC_NULL_HANDLE) || (defaultFragmentShader == GLC_NULL_HANDLE))
-		return EXIT_FAILURE;
+	GLCProgramCache programCache;
+	glcProgramCacheInit(&programCache);
 
-	const GLuint defaultProgram = glcCreateProgram(defaultVertexShader, defaultFragmentShader);
+	const GLuint defaultProgram = glcProgramCacheCreateProgram(&programCache, defaultVertexShaderSource, defaultFragmentShaderSource);
 
 	if (defaultProgram == GLC_NULL_HANDLE)
 		return EXIT_FAILURE;
 
-	glDeleteShader(defaultFragmentShader);
-	glDeleteShader(defaultVertexShader);
+	glcProgramCachePrintStats(&programCache);
+
+	// Editing shaders/visualize_normals.* while running reloads the program
+	GLCShaderWatcher watcher;
+	glcShaderWatcherInit(&watcher);
 
-	const GLuint visualizeNormalsVertexShader   = glcCreateShaderFromFile(GL_VERTEX_SHADER, "shaders/visualize_normals.vert");
-	const GLuint visualizeNormalsFragmentShader = glcCreateShaderFromFile(GL_FRAGMENT_SHADER, "shaders/visualize_normals.frag");
-	const GLuint visualizeNormalsGeometryShader = glcCreateShaderFromFile(GL_GEOMETRY_SHADER, "shaders/visualize_normals.geom");
+	const int visualizeNormalsID = glcWatchProgram(&watcher,
+			"shaders/visualize_normals.vert", "shaders/visualize_normals.frag", "shaders/visualize_normals.geom");
 
-	if ((visualizeNormalsVertexShader == GLC_NULL_HANDLE) || (visualizeNormalsFragmentShader == GLC_NULL_HANDLE) || (visualizeNormalsGeometryShader == GLC_NULL_HANDLE))
+	if (visualizeNormalsID == -1)
 		return EXIT_FAILURE;
 
-	const GLuint visualizeNormalsProgram = glcCreateProgram(visualizeNormalsVertexShader, visualizeNormalsFragmentShader, visualizeNormalsGeometryShader);
+	GLuint visualizeNormalsProgram = glcGetWatchedProgram(&watcher, visualizeNormalsID);
 
-	const GLint defaultMVPLocation = glGetUniformLocation(defaultProgram, "mvp");
-	const GLint visualizeNormalsMVPLocation = glGetUniformLocation(visualizeNormalsProgram, "mvp");
-	const GLint visualizeNormalsLengthLocation = glGetUniformLocation(visualizeNormalsProgram, "length");
+	glcShaderProfilePrint();
+	glcIncludeCachePrintStats(glcGetIncludeCache());
+
+	if (!glcShaderValidate)
+		printf("Shader Build: glValidateProgram skipped\n");
+
+	if (shaderTracePath && !glcShaderProfileWriteTrace(shaderTracePath))
+		fprintf(stderr, "Failed writing %s\n", shaderTracePath);
+
+	// Reloads are not part of startup
+	glcShaderProfileEnable(0);
+
+	// Both programs share the vertex array
+	static_assert(GLC_VISUALIZE_NORMALS_POSITION_LOCATION == GLC_ATTRIBUTE_POSITION, "");
+	static_assert(GLC_VISUALIZE_NORMALS_NORMAL_LOCATION == GLC_ATTRIBUTE_NORMAL, "");
+
+	// The locations and bindings of visualize_normals are fixed by the shaders,
+	// the default program is not in shaders/, so its block is bound here
+	GLCProgramReflection defaultReflection;
+
+	if (!glcReflectProgram(&defaultReflection, defaultProgram))
+		return EXIT_FAILURE;
+
+	// Both programs read the MVP from the same block, uploaded once per frame
+	if (glcUniformBlockBind(&defaultReflection, glcInternName("Transforms"), GLC_TRANSFORMS_BINDING) != (GLint) sizeof(GLCTransformsBlock))
+		return EXIT_FAILURE;
+
+	GLCVisualizeNormalsUniforms visualizeNormalsUniforms;
+	visualizeNormalsUniforms.length = 0.2f;
+
+	GLCStateCache state;
+	glcStateInit(&state);
+
+	// The transforms are written straight into mapped memory, a region per
+	// frame in flight
+	GLCStreamBuffer stream;
+
+	if (!glcStreamBufferCreate(&stream, &state, GL_UNIFORM_BUFFER, 64 * 1024, GLC_STREAM_FRAME_COUNT, 0, streamMode))
+		return EXIT_FAILURE;
 
 	char *str = loadFile("models/suzanne.obj");
 
@@ -145,10 +214,10 @@ int main(int argc, char *argv[])
 	GLuint vao, vbo;
 
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	glcStateBindVertexArray(&state, vao);
 
 	glCreateBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glcStateBindBuffer(&state, GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(LoadOBJTriangleVertex), trimesh.vertices, GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(GLC_ATTRIBUTE_POSITION);
@@ -159,58 +228,157 @@ int main(int argc, char *argv[])
 
 	loadOBJDestroyTriangleMesh(&trimesh);
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	GLuint cubeVao, cubeVbo;
+
+	glGenVertexArrays(1, &cubeVao);
+	glcStateBindVertexArray(&state, cubeVao);
+
+	glGenBuffers(1, &cubeVbo);
+	glcStateBindBuffer(&state, GL_ARRAY_BUFFER, cubeVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glcCubeVertices), glcCubeVertices, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(GLC_ATTRIBUTE_POSITION);
+	glVertexAttribPointer(GLC_ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, GLC_CUBE_VERTEX_SIZE * sizeof(GLfloat), 0);
+
+	glEnableVertexAttribArray(GLC_ATTRIBUTE_NORMAL);
+	glVertexAttribPointer(GLC_ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, GLC_CUBE_VERTEX_SIZE * sizeof(GLfloat), (const GLvoid*) (3 * sizeof(GLfloat)));
+
+	GLCDrawQueue drawQueue;
+	glcDrawQueueInit(&drawQueue);
 
-	float model[16], view[16], projection[16];
-	float mvp[16];
-	float temp[16];
+	// Suzanne in the middle, with a ring of cubes and smaller suzannes around it
+	static const int objectCount = 9;
+	static const float ringRadius = 1.8f;
+
+	float model[16], view[16];
+	float viewProjection[16], mvp[16];
 
 	static const float fov   = 70.0f;
 	static const float zNear = 0.01f;
 	static const float zFar  = 10.0f;
 
-	glUseProgram(visualizeNormalsProgram);
-	glUniform1f(visualizeNormalsLengthLocation, 0.2f);
+	glcStateUseProgram(&state, visualizeNormalsProgram);
+	glcSetVisualizeNormalsUniforms(&visualizeNormalsUniforms);
 
 	while (!glfwWindowShouldClose(window))
 	{
+		if (glcShaderWatcherUpdate(&watcher))
+		{
+			visualizeNormalsProgram = glcGetWatchedProgram(&watcher, visualizeNormalsID);
+
+			// The watcher deleted the old program behind the cache's back
+			glcStateInvalidate(&state);
+
+			glcStateUseProgram(&state, visualizeNormalsProgram);
+			glcSetVisualizeNormalsUniforms(&visualizeNormalsUniforms);
+		}
+
 		int viewportWidth, viewportHeight;
 		glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
 
 		const float aspect = static_cast<float>(viewportWidth) / static_cast<float>(viewportHeight);
 		const float time = static_cast<GLfloat>(glfwGetTime());
 
-		mat4Perspective(projection, fov, aspect, zNear, zFar);
-
 		mat4Identity(view);
 		mat4Translate(view, 0.0f, 0.0f, -3.0f);
 		mat4Rotate(view, GLC_RAD(cosf(time * 0.75f) * 16.0f), 1.0f, 0.0f, 0.0f);
 
-		mat4Rotation(model, time * 0.5f, 0.0f, 1.0f, 0.0f);
+		mat4PerspectiveMultiply(viewProjection, fov, aspect, zNear, zFar, view);
+
+		if (!glcStreamBufferBeginFrame(&stream, &state))
+			break;
+
+		glcDrawQueueReset(&drawQueue);
+
+		// Pushed in scene order, alternating programs and vertex arrays. The
+		// queue groups them and orders each group front to back
+		for (int i = 0; i < objectCount; ++i)
+		{
+			const int isCube = (i % 2) == 1;
+
+			if (i == 0)
+			{
+				mat4Rotation(model, time * 0.5f, 0.0f, 1.0f, 0.0f);
+			}
+			else
+			{
+				const float angle = time * 0.25f + (float) i * (2.0f * GLC_PI / (float) (objectCount - 1));
+
+				mat4Translation(model, cosf(angle) * ringRadius, 0.0f, sinf(angle) * ringRadius);
+				mat4Rotate(model, time, 0.0f, 1.0f, 0.0f);
+				mat4Scale(model, 0.4f, 0.4f, 0.4f);
+			}
+
+			mat4Multiply(mvp, viewProjection, model);
+
+			GLCDrawCommand command;
+			memset(&command, 0, sizeof(command));
+
+			GLCTransformsBlock *transforms = (GLCTransformsBlock*) glcStreamBufferAlloc(&stream, &state, sizeof(GLCTransformsBlock), &command.uniformOffset);
+
+			if (!transforms)
+				break;
 
-		mat4Multiply(temp, projection, view);
-		mat4Multiply(mvp, temp, model);
+			memcpy(transforms->mvp, mvp, sizeof(mvp));
 
-		glViewport(0, 0, viewportWidth, viewportHeight);
+			command.uniformBuffer = stream.buffer;
+			command.uniformBinding = GLC_TRANSFORMS_BINDING;
+			command.uniformSize = sizeof(GLCTransformsBlock);
+
+			command.vertexArray = isCube ? cubeVao : vao;
+			command.count = isCube ? glcCubeVertexCount : vertexCount;
+
+			// The clip w of the origin is its view depth
+			const float depth = mvp[15] / zFar;
+
+			command.program = defaultProgram;
+			command.mode = GL_TRIANGLES;
+			command.key = glcDrawKey(0, command.program, command.vertexArray, 0, depth);
+
+			glcDrawQueuePush(&drawQueue, &command);
+
+			// Normals go in a later pass, testing against the shaded surfaces
+			command.program = visualizeNormalsProgram;
+			command.mode = GL_POINTS;
+			command.key = glcDrawKey(1, command.program, command.vertexArray, 0, depth);
+
+			glcDrawQueuePush(&drawQueue, &command);
+		}
+
+		glcStreamBufferFlush(&stream, &state);
+
+		glcStateViewport(&state, 0, 0, viewportWidth, viewportHeight);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glUseProgram(defaultProgram);
-		glUniformMatrix4fv(defaultMVPLocation, 1, GL_FALSE, mvp);
-		glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+		glcStateEnable(&state, GL_DEPTH_TEST);
+		glcStateEnable(&state, GL_CULL_FACE);
+
+		glcDrawQueueSubmit(&drawQueue, &state);
 
-		glUseProgram(visualizeNormalsProgram);
-		glUniformMatrix4fv(visualizeNormalsMVPLocation, 1, GL_FALSE, mvp);
-		glDrawArrays(GL_POINTS, 0, vertexCount);
+		glcStreamBufferEndFrame(&stream, &state);
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
-	glDeleteVertexArrays(1, &vao);
-	glDeleteBuffers(1, &vbo);
+	glcDrawQueuePrintStats(&drawQueue);
+	glcStatePrintStats(&state);
+	glcStreamBufferPrintStats(&stream);
+
+	glcDrawQueueDestroy(&drawQueue);
+
+	glcStateDeleteVertexArrays(&state, 1, &cubeVao);
+	glcStateDeleteBuffers(&state, 1, &cubeVbo);
+
+	glcStateDeleteVertexArrays(&state, 1, &vao);
+	glcStateDeleteBuffers(&state, 1, &vbo);
+
+	glcReflectionDestroy(&defaultReflection);
+
+	glcStreamBufferDestroy(&stream, &state);
 
-	glDeleteProgram(defaultProgram);
+	glcShaderWatcherDestroy(&watcher);
+	glcStateDeleteProgram(&state, defaultProgram);
 
 	glfwDestroyWindow(window);
 	glfwTerminate();